@@ -0,0 +1,353 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DARWIN_C_SOURCE        /* macOS hides _SC_NPROCESSORS_ONLN under plain POSIX */
+
+#include "mew.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Batch evaluator: one operation per line, hex operands, one hex result per
+ * line in the same order.
+ *
+ *   modpow base exp mod
+ *   mul a b
+ *
+ * Blank lines and lines starting with '#' produce no output; malformed lines
+ * print "error".
+ *
+ * The input is memory-mapped and cut into chunks at line boundaries. Workers
+ * claim chunks, format results into a per-chunk buffer and the main thread
+ * writes finished chunks in order. At most WINDOW_PER_THREAD chunks per
+ * worker are in flight, so memory stays bounded on any input size.
+ */
+
+#define CHUNK_BYTES       (64 * 1024)
+#define WINDOW_PER_THREAD 4
+#define MAX_ARGS          3
+#define LINE_OUT_MAX      (NUM_LEN * 8 + 2)
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    char *out;
+    size_t out_len;
+    bool done;
+} Chunk;
+
+typedef struct {
+    Chunk *chunks;
+    size_t count;
+    size_t next;
+    size_t written;
+    size_t window;
+    pthread_mutex_t lock;
+    pthread_cond_t progress;
+} Batch;
+
+typedef struct {
+    MewMod ctx;
+    bool valid;
+} ModCache;
+
+typedef enum {
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_GCD, OP_ISQRT,
+    OP_MODADD, OP_MODSUB, OP_MODMUL, OP_MODPOW,
+    OP_UNKNOWN
+} OpCode;
+
+static const struct {
+    const char *name;
+    OpCode op;
+    int nargs;
+} OPS[] = {
+    {"add", OP_ADD, 2},       {"sub", OP_SUB, 2},       {"mul", OP_MUL, 2},
+    {"div", OP_DIV, 2},       {"mod", OP_MOD, 2},       {"gcd", OP_GCD, 2},
+    {"isqrt", OP_ISQRT, 1},   {"modadd", OP_MODADD, 3}, {"modsub", OP_MODSUB, 3},
+    {"modmul", OP_MODMUL, 3}, {"modpow", OP_MODPOW, 3},
+};
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static OpCode lookup_op(const char *s, size_t len, int *nargs) {
+    for (size_t i = 0; i < sizeof(OPS) / sizeof(OPS[0]); ++i) {
+        if (strlen(OPS[i].name) == len && !memcmp(OPS[i].name, s, len)) {
+            *nargs = OPS[i].nargs;
+            return OPS[i].op;
+        }
+    }
+    return OP_UNKNOWN;
+}
+
+/* consecutive lines usually share a modulus, so keep the last context per worker */
+static const MewMod *cached_context(ModCache *cache, const Mew *mod) {
+    if (!cache->valid || cmp(&cache->ctx.n, mod) != 0) {
+        cache->ctx = mod_context(mod);
+        cache->valid = !cache->ctx.chozabretto;
+    }
+    return &cache->ctx;
+}
+
+static Mew eval_line(const char *p, const char *end, ModCache *cache) {
+    Mew err = zero();
+    err.chozabretto = true;
+
+    while (p < end && is_space(*p)) ++p;
+    const char *name = p;
+    while (p < end && !is_space(*p)) ++p;
+
+    int nargs = 0;
+    OpCode op = lookup_op(name, (size_t)(p - name), &nargs);
+    if (op == OP_UNKNOWN) return err;
+
+    Mew args[MAX_ARGS];
+    for (int i = 0; i < nargs; ++i) {
+        while (p < end && is_space(*p)) ++p;
+        const char *tok = p;
+        while (p < end && !is_space(*p)) ++p;
+        if (p == tok) return err;
+        args[i] = from_hex_n(tok, (size_t)(p - tok));
+        if (args[i].chozabretto) return err;
+    }
+    while (p < end && is_space(*p)) ++p;
+    if (p < end) return err;
+
+    switch (op) {
+    case OP_ADD:    return add(&args[0], &args[1]);
+    case OP_SUB:    return sub(&args[0], &args[1]);
+    case OP_MUL:    return mul(&args[0], &args[1]);
+    case OP_DIV:    return divm(&args[0], &args[1]);
+    case OP_MOD:    return modm(&args[0], &args[1]);
+    case OP_GCD:    return gcd(&args[0], &args[1]);
+    case OP_ISQRT:  return isqrt(&args[0]);
+    default:        break;
+    }
+
+    if (is_zero(&args[2])) return err;
+    const MewMod *m = cached_context(cache, &args[2]);
+    if (m->chozabretto) return err;
+
+    switch (op) {
+    case OP_MODADD: return mod_add_ctx(m, &args[0], &args[1]);
+    case OP_MODSUB: return mod_subtract_ctx(m, &args[0], &args[1]);
+    case OP_MODMUL: return mod_multiply_ctx(m, &args[0], &args[1]);
+    case OP_MODPOW: return mod_pow_ctx(m, &args[0], &args[1]);
+    default:        return err;
+    }
+}
+
+static void run_chunk(Chunk *c, ModCache *cache) {
+    size_t cap = (size_t)(c->end - c->begin) + LINE_OUT_MAX;
+    c->out = malloc(cap);
+    c->out_len = 0;
+    if (!c->out) return;
+
+    const char *p = c->begin;
+    while (p < c->end) {
+        const char *nl = memchr(p, '\n', (size_t)(c->end - p));
+        const char *eol = nl ? nl : c->end;
+
+        if (c->out_len + LINE_OUT_MAX > cap) {
+            cap *= 2;
+            char *grown = realloc(c->out, cap);
+            if (!grown) {
+                free(c->out);
+                c->out = NULL;
+                return;
+            }
+            c->out = grown;
+        }
+
+        const char *q = p;
+        while (q < eol && is_space(*q)) ++q;
+        if (q < eol && *q != '#') {
+            Mew r = eval_line(q, eol, cache);
+            if (r.negative) c->out[c->out_len++] = '-';
+            int n = to_hex_buf(&r, c->out + c->out_len, cap - c->out_len);
+            c->out_len += (size_t)n;
+            c->out[c->out_len++] = '\n';
+        }
+        p = eol + 1;
+    }
+}
+
+static void *worker(void *arg) {
+    Batch *b = arg;
+    ModCache cache = {0};
+
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        while (b->next < b->count && b->next >= b->written + b->window)
+            pthread_cond_wait(&b->progress, &b->lock);
+        if (b->next >= b->count) {
+            pthread_mutex_unlock(&b->lock);
+            return NULL;
+        }
+        Chunk *c = &b->chunks[b->next++];
+        pthread_mutex_unlock(&b->lock);
+
+        run_chunk(c, &cache);
+
+        pthread_mutex_lock(&b->lock);
+        c->done = true;
+        pthread_cond_broadcast(&b->progress);
+        pthread_mutex_unlock(&b->lock);
+    }
+}
+
+static size_t split_chunks(const char *data, size_t size, Chunk **out) {
+    size_t cap = size / CHUNK_BYTES + 2;
+    Chunk *chunks = calloc(cap, sizeof(Chunk));
+    if (!chunks) return 0;
+
+    size_t n = 0;
+    const char *p = data, *end = data + size;
+    while (p < end) {
+        const char *stop = (size_t)(end - p) > CHUNK_BYTES ? p + CHUNK_BYTES : end;
+        if (stop < end) {
+            const char *nl = memchr(stop, '\n', (size_t)(end - stop));
+            stop = nl ? nl + 1 : end;
+        }
+        chunks[n].begin = p;
+        chunks[n].end = stop;
+        ++n;
+        p = stop;
+    }
+    *out = chunks;
+    return n;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-j threads] input [output]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int threads = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    int argi = 1;
+    if (argi + 1 < argc && !strcmp(argv[argi], "-j")) {
+        threads = atoi(argv[argi + 1]);
+        argi += 2;
+    }
+    if (threads < 1) threads = 1;
+    if (argi >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int fd = open(argv[argi], O_RDONLY);
+    if (fd < 0) {
+        perror(argv[argi]);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(argv[argi]);
+        close(fd);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (argi + 1 < argc) {
+        out = fopen(argv[argi + 1], "w");
+        if (!out) {
+            perror(argv[argi + 1]);
+            close(fd);
+            return 1;
+        }
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        if (fclose(out) != 0) {
+            perror("write");
+            return 1;
+        }
+        return 0;
+    }
+
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    Batch b;
+    memset(&b, 0, sizeof(b));
+    b.count = split_chunks(data, size, &b.chunks);
+    b.window = (size_t)threads * WINDOW_PER_THREAD;
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_cond_init(&b.progress, NULL);
+
+    pthread_t *pool = malloc((size_t)threads * sizeof(pthread_t));
+    if (!b.chunks || !pool) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    int started = 0;
+    for (int i = 0; i < threads; ++i) {
+        if (pthread_create(&pool[started], NULL, worker, &b) != 0) break;
+        ++started;
+    }
+
+    /* no worker could start: evaluate each chunk here before writing it */
+    ModCache cache = {0};
+
+    int status = 0;
+    bool write_failed = false;
+    for (size_t i = 0; i < b.count; ++i) {
+        if (!started) {
+            run_chunk(&b.chunks[i], &cache);
+            b.chunks[i].done = true;
+        }
+
+        pthread_mutex_lock(&b.lock);
+        while (!b.chunks[i].done)
+            pthread_cond_wait(&b.progress, &b.lock);
+        pthread_mutex_unlock(&b.lock);
+
+        /* after a failed write keep draining so the workers can finish */
+        Chunk *c = &b.chunks[i];
+        if (!c->out) {
+            fprintf(stderr, "out of memory\n");
+            status = 1;
+        } else if (!write_failed && fwrite(c->out, 1, c->out_len, out) != c->out_len) {
+            perror("write");
+            write_failed = true;
+            status = 1;
+        }
+        free(c->out);
+        c->out = NULL;
+
+        pthread_mutex_lock(&b.lock);
+        b.written = i + 1;
+        pthread_cond_broadcast(&b.progress);
+        pthread_mutex_unlock(&b.lock);
+    }
+
+    for (int i = 0; i < started; ++i)
+        pthread_join(pool[i], NULL);
+
+    free(pool);
+    free(b.chunks);
+    munmap((void *)data, size);
+    pthread_mutex_destroy(&b.lock);
+    pthread_cond_destroy(&b.progress);
+    /* fclose flushes, so a full disk or closed pipe may only show up here */
+    if (fclose(out) != 0 && !write_failed) {
+        perror("write");
+        status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,234 @@
+#include "mew.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Discrete logarithms in (Z/pZ)*: find x in [0, range) with g^x = h.
+ *
+ * dlog_bsgs is baby-step giant-step. The babies go in a fingerprint MewTable,
+ * which keeps only the hash of g^j and j, never the residue, so a baby step
+ * costs one table slot whatever the modulus size. When sqrt(range) babies do
+ * not fit in max_bytes, fewer babies and more giant steps are used. A
+ * fingerprint hit is confirmed with one exponentiation. Giant steps are split across
+ * threads by residue class: worker t takes i = t, t + T, t + 2T, ... and
+ * stops once i m passes the smallest solution found so far.
+ *
+ * dlog_kangaroo is Pollard's lambda method: O(sqrt(range)) multiplications
+ * and constant memory, but probabilistic; failed walks are retried with a
+ * fresh jump function.
+ */
+
+#define BSGS_SLOT_BYTES   48       /* first guess per baby, table_bytes has the last word */
+#define BSGS_MAX_THREADS  64
+#define KANGAROO_TRIES    8
+#define KANGAROO_MAX_JUMP 63
+
+typedef struct {
+    const MewMod *m;
+    const Mew *g;
+    const Mew *h;
+    uint64_t range;
+    uint64_t babies;
+    uint64_t giants;
+
+    MewTable *baby;            /* fingerprint of g^j -> j */
+
+    Mew giant;                 /* g^-m */
+    Mew stride;                /* g^-(m T) */
+    int threads;
+    _Atomic uint64_t best;
+} Bsgs;
+
+typedef struct {
+    Bsgs *b;
+    int id;
+} BsgsArg;
+
+
+static uint64_t isqrt_u64(uint64_t n) {
+    uint64_t r = 0;
+    for (uint64_t bit = 1ull << 62; bit; bit >>= 2) {
+        if (n >= r + bit) {
+            n -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return r;
+}
+
+static Mew pow_u64(const MewMod *m, const Mew *g, uint64_t e) {
+    Mew lo = from_u32((uint32_t)e);
+    Mew hi = from_u32((uint32_t)(e >> 32));
+    hi = shift_left(&hi, 32);
+    Mew ex = add(&lo, &hi);
+    return mod_pow_ctx(m, g, &ex);
+}
+
+static bool verify(const Bsgs *b, uint64_t x) {
+    Mew y = pow_u64(b->m, b->g, x);
+    return cmp(&y, b->h) == 0;
+}
+
+static void found(Bsgs *b, uint64_t x) {
+    uint64_t cur = atomic_load(&b->best);
+    while (x < cur && !atomic_compare_exchange_weak(&b->best, &cur, x)) {}
+}
+
+static void *bsgs_giants(void *p) {
+    BsgsArg *arg = p;
+    Bsgs *b = arg->b;
+    const MewMod *m = b->m;
+
+    /* y = h g^(-m t) */
+    Mew e = from_u32((uint32_t)arg->id);
+    Mew y = mod_pow_ctx(m, &b->giant, &e);
+    y = mod_multiply_ctx(m, b->h, &y);
+
+    for (uint64_t i = (uint64_t)arg->id; i < b->giants; i += (uint64_t)b->threads) {
+        if (i * b->babies >= atomic_load_explicit(&b->best, memory_order_relaxed)) break;
+
+        uint64_t j;
+        if (table_get(b->baby, &y, &j)) {
+            uint64_t x = i * b->babies + j;
+            if (x < b->range && verify(b, x)) found(b, x);
+        }
+        y = mod_multiply_ctx(m, &y, &b->stride);
+    }
+    return NULL;
+}
+
+bool dlog_bsgs(const MewMod *m, const Mew *g, const Mew *h, uint64_t range,
+               size_t max_bytes, int threads, uint64_t *x) {
+    if (!m || !g || !h || !x || m->chozabretto || range == 0) return false;
+    if (threads < 1) threads = 1;
+    if (threads > BSGS_MAX_THREADS) threads = BSGS_MAX_THREADS;
+
+    Bsgs b;
+    memset(&b, 0, sizeof(b));
+    b.m = m;
+    b.range = range;
+    b.threads = threads;
+    atomic_init(&b.best, UINT64_MAX);
+
+    Mew hr = mod_reduce(m, h);
+    Mew gr = mod_reduce(m, g);
+    b.g = &gr;
+    b.h = &hr;
+
+    b.babies = isqrt_u64(range);
+    if (b.babies * b.babies < range) ++b.babies;
+    if (max_bytes / BSGS_SLOT_BYTES < b.babies) b.babies = max_bytes / BSGS_SLOT_BYTES;
+    if (b.babies == 0) b.babies = 1;
+
+    for (;;) {
+        b.baby = table_new_fingerprint(b.babies, 0x6A09E667F3BCC909ull);
+        if (!b.baby) return false;
+        if (b.babies == 1 || table_bytes(b.baby) <= max_bytes) break;
+        table_free(b.baby);
+        b.babies /= 2;
+    }
+    b.giants = (range + b.babies - 1) / b.babies;
+
+    Mew gj = from_u32(1);
+    gj = mod_reduce(m, &gj);
+    for (uint64_t j = 0; j < b.babies; ++j) {
+        /* g^j repeats: the order is below m, keep the smaller exponent */
+        if (!table_get(b.baby, &gj, NULL)) table_put(b.baby, &gj, j);
+        gj = mod_multiply_ctx(m, &gj, &gr);
+    }
+
+    /* gj is now g^m */
+    Mew inv = mod_inverse_ctx(m, &gj);
+    if (inv.chozabretto) {
+        table_free(b.baby);
+        return false;
+    }
+    b.giant = inv;
+    Mew t = from_u32((uint32_t)threads);
+    b.stride = mod_pow_ctx(m, &inv, &t);
+
+    pthread_t pool[BSGS_MAX_THREADS];
+    BsgsArg args[BSGS_MAX_THREADS];
+    int started = 0;
+    for (int i = 0; i < threads; ++i) {
+        args[i].b = &b;
+        args[i].id = i;
+    }
+    if (threads > 1) {
+        for (int i = 0; i < threads; ++i) {
+            if (pthread_create(&pool[i], NULL, bsgs_giants, &args[i]) != 0) break;
+            ++started;
+        }
+    }
+    if (started < threads) {
+        /* run the classes no thread picked up on the caller */
+        for (int i = started; i < threads; ++i) bsgs_giants(&args[i]);
+    }
+    for (int i = 0; i < started; ++i)
+        pthread_join(pool[i], NULL);
+
+    table_free(b.baby);
+    uint64_t r = atomic_load(&b.best);
+    if (r == UINT64_MAX) return false;
+    *x = r;
+    return true;
+}
+
+
+bool dlog_kangaroo(const MewMod *m, const Mew *g, const Mew *h, uint64_t range,
+                   uint64_t seed, uint64_t *x) {
+    if (!m || !g || !h || !x || m->chozabretto || range == 0 || range > (1ull << 62)) return false;
+
+    Mew gr = mod_reduce(m, g);
+    Mew hr = mod_reduce(m, h);
+
+    /* jumps 2^0 .. 2^(k-1), mean about sqrt(range) / 2 */
+    uint64_t root = isqrt_u64(range) + 1;
+    int k = 1;
+    while (k < KANGAROO_MAX_JUMP && ((1ull << k) - 1) / (uint64_t)k < root / 2) ++k;
+
+    Mew jump[KANGAROO_MAX_JUMP];
+    jump[0] = gr;
+    for (int i = 1; i < k; ++i) jump[i] = mod_square_ctx(m, &jump[i - 1]);
+
+    uint64_t top = range - 1;
+    Mew start = pow_u64(m, &gr, top);
+
+    for (int attempt = 0; attempt < KANGAROO_TRIES; ++attempt) {
+        uint64_t hs = seed + (uint64_t)attempt * 0x9E3779B97F4A7C15ull;
+
+        /* tame: from g^top, about sqrt(range) jumps, then set the trap */
+        Mew tame = start;
+        uint64_t dt = 0;
+        for (uint64_t s = 0; s < root; ++s) {
+            int i = (int)(hash_mew(&tame, hs) % (uint64_t)k);
+            tame = mod_multiply_ctx(m, &tame, &jump[i]);
+            dt += 1ull << i;
+        }
+
+        /* wild: from h until it lands on the trap or runs past it */
+        Mew wild = hr;
+        uint64_t dw = 0;
+        while (dw <= top + dt) {
+            if (cmp(&wild, &tame) == 0) {
+                uint64_t cand = top + dt - dw;
+                if (cand < range) {
+                    Mew y = pow_u64(m, &gr, cand);
+                    if (cmp(&y, &hr) == 0) {
+                        *x = cand;
+                        return true;
+                    }
+                }
+                break;
+            }
+            int i = (int)(hash_mew(&wild, hs) % (uint64_t)k);
+            wild = mod_multiply_ctx(m, &wild, &jump[i]);
+            dw += 1ull << i;
+        }
+    }
+    return false;
+}
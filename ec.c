@@ -0,0 +1,426 @@
+#include "mew.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Short Weierstrass curves y^2 = x^3 + ax + b over a prime field, points in
+ * homogeneous projective coordinates (X:Y:Z) with the point at infinity
+ * (0:1:0). Addition and doubling are the complete formulas of Renes,
+ * Costello and Batina: one code path for every input pair, including
+ * P + P, P + (-P) and the point at infinity, and no inversions.
+ *
+ * All field arithmetic runs on the curve's MewMod, so P-256 and secp256k1
+ * reduce by folding rather than by Barrett.
+ */
+
+#define EC_WNAF_WIDTH  5
+#define EC_WNAF_TABLE  (1 << (EC_WNAF_WIDTH - 2))
+#define EC_COMB_BITS   4
+#define EC_COMB_TABLE  (1 << (EC_COMB_BITS - 1))
+
+struct MewEcTable {
+    MewCurve curve;
+    int windows;
+    MewPoint *points;          /* windows * EC_COMB_TABLE, j 16^i P at [i][j - 1] */
+};
+
+
+static MewCurve ec_curve_error(void) {
+    MewCurve c;
+    memset(&c, 0, sizeof(c));
+    c.chozabretto = true;
+    return c;
+}
+
+static MewPoint ec_point_error(void) {
+    MewPoint p = ec_infinity();
+    p.x.chozabretto = true;
+    return p;
+}
+
+MewCurve ec_curve(const Mew *p, const Mew *a, const Mew *b) {
+    if (!p || !a || !b || a->chozabretto || b->chozabretto) return ec_curve_error();
+
+    MewCurve c;
+    memset(&c, 0, sizeof(c));
+    c.f = mod_context(p);
+    if (c.f.chozabretto) return ec_curve_error();
+
+    c.a = mod_reduce(&c.f, a);
+    c.b = mod_reduce(&c.f, b);
+    Mew three = from_u32(3);
+    c.b3 = mod_multiply_ctx(&c.f, &three, &c.b);
+    c.gx = zero();
+    c.gy = zero();
+    c.order = zero();
+    return c;
+}
+
+static MewCurve ec_curve_named(const char *p, const char *a, const char *b,
+                               const char *gx, const char *gy, const char *order) {
+    Mew pm = from_hex(p), am = from_hex(a), bm = from_hex(b);
+    MewCurve c = ec_curve(&pm, &am, &bm);
+    if (c.chozabretto) return c;
+
+    c.gx = from_hex(gx);
+    c.gy = from_hex(gy);
+    c.order = from_hex(order);
+    return c;
+}
+
+MewCurve ec_curve_p256(void) {
+    return ec_curve_named(
+        "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff",
+        "ffffffff00000001000000000000000000000000fffffffffffffffffffffffc",
+        "5ac635d8aa3a93e7b3ebbd55769886bc651d06b0cc53b0f63bce3c3e27d2604b",
+        "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+        "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5",
+        "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551");
+}
+
+MewCurve ec_curve_secp256k1(void) {
+    return ec_curve_named(
+        "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f",
+        "0",
+        "7",
+        "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798",
+        "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8",
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141");
+}
+
+MewPoint ec_infinity(void) {
+    MewPoint p;
+    p.x = zero();
+    p.y = from_u32(1);
+    p.z = zero();
+    return p;
+}
+
+MewPoint ec_point(const MewCurve *c, const Mew *x, const Mew *y) {
+    if (!c || c->chozabretto || !x || !y) return ec_point_error();
+
+    MewPoint p;
+    p.x = mod_reduce(&c->f, x);
+    p.y = mod_reduce(&c->f, y);
+    p.z = from_u32(1);
+    return p;
+}
+
+MewPoint ec_generator(const MewCurve *c) {
+    if (!c || c->chozabretto || is_zero(&c->order)) return ec_point_error();
+    return ec_point(c, &c->gx, &c->gy);
+}
+
+bool ec_is_infinity(const MewPoint *p) {
+    return is_zero(&p->z);
+}
+
+/* Y^2 Z = X^3 + a X Z^2 + b Z^3 */
+bool ec_on_curve(const MewCurve *c, const MewPoint *p) {
+    if (!c || !p || c->chozabretto || p->x.chozabretto) return false;
+    if (ec_is_infinity(p)) return true;
+
+    const MewMod *f = &c->f;
+    Mew y2 = mod_square_ctx(f, &p->y);
+    Mew lhs = mod_multiply_ctx(f, &y2, &p->z);
+
+    Mew z2 = mod_square_ctx(f, &p->z);
+    Mew z3 = mod_multiply_ctx(f, &z2, &p->z);
+    Mew x2 = mod_square_ctx(f, &p->x);
+    Mew rhs = mod_multiply_ctx(f, &x2, &p->x);
+    Mew t = mod_multiply_ctx(f, &c->a, &p->x);
+    t = mod_multiply_ctx(f, &t, &z2);
+    rhs = mod_add_ctx(f, &rhs, &t);
+    t = mod_multiply_ctx(f, &c->b, &z3);
+    rhs = mod_add_ctx(f, &rhs, &t);
+
+    return cmp(&lhs, &rhs) == 0;
+}
+
+bool ec_equal(const MewCurve *c, const MewPoint *p, const MewPoint *q) {
+    bool pi = ec_is_infinity(p), qi = ec_is_infinity(q);
+    if (pi || qi) return pi == qi;
+
+    const MewMod *f = &c->f;
+    Mew l = mod_multiply_ctx(f, &p->x, &q->z);
+    Mew r = mod_multiply_ctx(f, &q->x, &p->z);
+    if (cmp(&l, &r) != 0) return false;
+    l = mod_multiply_ctx(f, &p->y, &q->z);
+    r = mod_multiply_ctx(f, &q->y, &p->z);
+    return cmp(&l, &r) == 0;
+}
+
+bool ec_to_affine(const MewCurve *c, const MewPoint *p, Mew *x, Mew *y) {
+    if (!c || !p || c->chozabretto || ec_is_infinity(p)) return false;
+
+    Mew zi = mod_inverse_ctx(&c->f, &p->z);
+    if (zi.chozabretto) return false;
+    *x = mod_multiply_ctx(&c->f, &p->x, &zi);
+    *y = mod_multiply_ctx(&c->f, &p->y, &zi);
+    return true;
+}
+
+/* the point with this x and the given parity of y, from y^2 = x^3 + ax + b */
+bool ec_decompress(const MewCurve *c, const Mew *x, bool odd, MewPoint *p) {
+    if (!c || !x || !p || c->chozabretto || x->chozabretto) return false;
+
+    const MewMod *f = &c->f;
+    Mew xr = mod_reduce(f, x);
+    Mew rhs = mod_square_ctx(f, &xr);
+    rhs = mod_add_ctx(f, &rhs, &c->a);
+    rhs = mod_multiply_ctx(f, &rhs, &xr);
+    rhs = mod_add_ctx(f, &rhs, &c->b);
+
+    MewSqrt sq = sqrt_context(f);
+    Mew y;
+    if (!mod_sqrt_ctx(&sq, &rhs, &y)) return false;
+    if (!is_zero(&y) && (bool)(y.numberArray[0] & 1) != odd) y = sub(&f->n, &y);
+
+    *p = ec_point(c, &xr, &y);
+    return true;
+}
+
+MewPoint ec_negate(const MewCurve *c, const MewPoint *p) {
+    MewPoint r = *p;
+    if (!is_zero(&r.y)) r.y = sub(&c->f.n, &p->y);
+    return r;
+}
+
+static Mew mul_a(const MewCurve *c, const Mew *t) {
+    if (is_zero(&c->a)) return zero();
+    return mod_multiply_ctx(&c->f, &c->a, t);
+}
+
+/* RCB algorithm 1: 12M + 3 m_a + 2 m_3b */
+MewPoint ec_add(const MewCurve *c, const MewPoint *p, const MewPoint *q) {
+    const MewMod *f = &c->f;
+    Mew t0, t1, t2, t3, t4, t5;
+    MewPoint r;
+
+    t0 = mod_multiply_ctx(f, &p->x, &q->x);
+    t1 = mod_multiply_ctx(f, &p->y, &q->y);
+    t2 = mod_multiply_ctx(f, &p->z, &q->z);
+    t3 = mod_add_ctx(f, &p->x, &p->y);
+    t4 = mod_add_ctx(f, &q->x, &q->y);
+    t3 = mod_multiply_ctx(f, &t3, &t4);
+    t4 = mod_add_ctx(f, &t0, &t1);
+    t3 = mod_subtract_ctx(f, &t3, &t4);
+    t4 = mod_add_ctx(f, &p->x, &p->z);
+    t5 = mod_add_ctx(f, &q->x, &q->z);
+    t4 = mod_multiply_ctx(f, &t4, &t5);
+    t5 = mod_add_ctx(f, &t0, &t2);
+    t4 = mod_subtract_ctx(f, &t4, &t5);
+    t5 = mod_add_ctx(f, &p->y, &p->z);
+    r.x = mod_add_ctx(f, &q->y, &q->z);
+    t5 = mod_multiply_ctx(f, &t5, &r.x);
+    r.x = mod_add_ctx(f, &t1, &t2);
+    t5 = mod_subtract_ctx(f, &t5, &r.x);
+    r.z = mul_a(c, &t4);
+    r.x = mod_multiply_ctx(f, &c->b3, &t2);
+    r.z = mod_add_ctx(f, &r.x, &r.z);
+    r.x = mod_subtract_ctx(f, &t1, &r.z);
+    r.z = mod_add_ctx(f, &t1, &r.z);
+    r.y = mod_multiply_ctx(f, &r.x, &r.z);
+    t1 = mod_add_ctx(f, &t0, &t0);
+    t1 = mod_add_ctx(f, &t1, &t0);
+    t2 = mul_a(c, &t2);
+    t4 = mod_multiply_ctx(f, &c->b3, &t4);
+    t1 = mod_add_ctx(f, &t1, &t2);
+    t2 = mod_subtract_ctx(f, &t0, &t2);
+    t2 = mul_a(c, &t2);
+    t4 = mod_add_ctx(f, &t4, &t2);
+    t0 = mod_multiply_ctx(f, &t1, &t4);
+    r.y = mod_add_ctx(f, &r.y, &t0);
+    t0 = mod_multiply_ctx(f, &t5, &t4);
+    r.x = mod_multiply_ctx(f, &t3, &r.x);
+    r.x = mod_subtract_ctx(f, &r.x, &t0);
+    t0 = mod_multiply_ctx(f, &t3, &t1);
+    r.z = mod_multiply_ctx(f, &t5, &r.z);
+    r.z = mod_add_ctx(f, &r.z, &t0);
+    return r;
+}
+
+/* RCB algorithm 3: 8M + 3S + 3 m_a + 2 m_3b */
+MewPoint ec_double(const MewCurve *c, const MewPoint *p) {
+    const MewMod *f = &c->f;
+    Mew t0, t1, t2, t3;
+    MewPoint r;
+
+    t0 = mod_square_ctx(f, &p->x);
+    t1 = mod_square_ctx(f, &p->y);
+    t2 = mod_square_ctx(f, &p->z);
+    t3 = mod_multiply_ctx(f, &p->x, &p->y);
+    t3 = mod_add_ctx(f, &t3, &t3);
+    r.z = mod_multiply_ctx(f, &p->x, &p->z);
+    r.z = mod_add_ctx(f, &r.z, &r.z);
+    r.x = mul_a(c, &r.z);
+    r.y = mod_multiply_ctx(f, &c->b3, &t2);
+    r.y = mod_add_ctx(f, &r.x, &r.y);
+    r.x = mod_subtract_ctx(f, &t1, &r.y);
+    r.y = mod_add_ctx(f, &t1, &r.y);
+    r.y = mod_multiply_ctx(f, &r.x, &r.y);
+    r.x = mod_multiply_ctx(f, &t3, &r.x);
+    r.z = mod_multiply_ctx(f, &c->b3, &r.z);
+    t2 = mul_a(c, &t2);
+    t3 = mod_subtract_ctx(f, &t0, &t2);
+    t3 = mul_a(c, &t3);
+    t3 = mod_add_ctx(f, &t3, &r.z);
+    r.z = mod_add_ctx(f, &t0, &t0);
+    t0 = mod_add_ctx(f, &r.z, &t0);
+    t0 = mod_add_ctx(f, &t0, &t2);
+    t0 = mod_multiply_ctx(f, &t0, &t3);
+    r.y = mod_add_ctx(f, &r.y, &t0);
+    t2 = mod_multiply_ctx(f, &p->y, &p->z);
+    t2 = mod_add_ctx(f, &t2, &t2);
+    t0 = mod_multiply_ctx(f, &t2, &t3);
+    r.x = mod_subtract_ctx(f, &r.x, &t0);
+    r.z = mod_multiply_ctx(f, &t2, &t1);
+    r.z = mod_add_ctx(f, &r.z, &r.z);
+    r.z = mod_add_ctx(f, &r.z, &r.z);
+    return r;
+}
+
+static uint32_t bits_at(const Mew *k, int pos, int n) {
+    uint32_t v = 0;
+    for (int i = 0; i < n; ++i) v |= bit_at(k, pos + i) << i;
+    return v;
+}
+
+/* width-w NAF: odd digits in (-2^(w-1), 2^(w-1)), at most one nonzero per w */
+static int wnaf_recode(const Mew *k, int w, int8_t *digits) {
+    int len = bit_len(k);
+    int bit = 0;
+    uint32_t carry = 0;
+
+    memset(digits, 0, (size_t)(len + w + 1));
+    while (bit < len || carry) {
+        if (bit_at(k, bit) == carry) {
+            ++bit;
+            continue;
+        }
+        int32_t word = (int32_t)(bits_at(k, bit, w) + carry);
+        carry = ((uint32_t)word >> (w - 1)) & 1;
+        word -= (int32_t)(carry << w);
+        digits[bit] = (int8_t)word;
+        bit += w;
+    }
+    return bit;
+}
+
+/* P, 3P, 5P, ... */
+static void odd_multiples(const MewCurve *c, const MewPoint *p, MewPoint *t, int n) {
+    MewPoint p2 = ec_double(c, p);
+    t[0] = *p;
+    for (int i = 1; i < n; ++i) t[i] = ec_add(c, &t[i - 1], &p2);
+}
+
+MewPoint ec_mul(const MewCurve *c, const Mew *k, const MewPoint *p) {
+    if (!c || !k || !p || c->chozabretto || k->chozabretto || p->x.chozabretto)
+        return ec_point_error();
+    if (is_zero(k) || ec_is_infinity(p)) return ec_infinity();
+
+    MewPoint base = k->negative ? ec_negate(c, p) : *p;
+    MewPoint table[EC_WNAF_TABLE];
+    odd_multiples(c, &base, table, EC_WNAF_TABLE);
+
+    int8_t digits[NUM_LEN * 32 + EC_WNAF_WIDTH + 1];
+    int len = wnaf_recode(k, EC_WNAF_WIDTH, digits);
+
+    MewPoint r = ec_infinity();
+    bool started = false;
+    for (int i = len - 1; i >= 0; --i) {
+        if (started) r = ec_double(c, &r);
+
+        int d = digits[i];
+        if (d > 0) {
+            r = started ? ec_add(c, &r, &table[(d - 1) / 2]) : table[(d - 1) / 2];
+            started = true;
+        } else if (d < 0) {
+            MewPoint neg = ec_negate(c, &table[(-d - 1) / 2]);
+            r = started ? ec_add(c, &r, &neg) : neg;
+            started = true;
+        }
+    }
+    return r;
+}
+
+
+/*
+ * Fixed-base tables: for every 4-bit window i the points j 16^i P with
+ * 1 <= j <= 8. Scalars are recoded to signed radix-16 digits in [-8, 8], so a
+ * multiplication is one table lookup and one addition per window and no
+ * doublings at all. Entries are made affine with one batch inversion.
+ */
+MewEcTable *ec_table_build(const MewCurve *c, const MewPoint *p, int bits) {
+    if (!c || !p || c->chozabretto || p->x.chozabretto || bits <= 0 || bits > NUM_LEN * 32)
+        return NULL;
+
+    MewEcTable *t = calloc(1, sizeof(MewEcTable));
+    if (!t) return NULL;
+    t->curve = *c;
+    t->windows = (bits + EC_COMB_BITS - 1) / EC_COMB_BITS + 1;
+
+    size_t count = (size_t)t->windows * EC_COMB_TABLE;
+    t->points = malloc(count * sizeof(MewPoint));
+    Mew *zs = malloc(count * sizeof(Mew));
+    Mew *scratch = malloc(count * sizeof(Mew));
+    if (!t->points || !zs || !scratch) {
+        free(zs);
+        free(scratch);
+        ec_table_free(t);
+        return NULL;
+    }
+
+    MewPoint base = *p;
+    for (int i = 0; i < t->windows; ++i) {
+        MewPoint *row = &t->points[(size_t)i * EC_COMB_TABLE];
+        row[0] = base;
+        for (int j = 1; j < EC_COMB_TABLE; ++j) row[j] = ec_add(c, &row[j - 1], &base);
+        for (int j = 0; j < EC_COMB_BITS; ++j) base = ec_double(c, &base);
+    }
+
+    /* a point at infinity in the table leaves it projective, which is still valid */
+    for (size_t i = 0; i < count; ++i) zs[i] = t->points[i].z;
+    if (mod_batch_inverse(&c->f, zs, zs, scratch, (int)count) == -1) {
+        for (size_t i = 0; i < count; ++i) {
+            t->points[i].x = mod_multiply_ctx(&c->f, &t->points[i].x, &zs[i]);
+            t->points[i].y = mod_multiply_ctx(&c->f, &t->points[i].y, &zs[i]);
+            t->points[i].z = from_u32(1);
+        }
+    }
+
+    free(zs);
+    free(scratch);
+    return t;
+}
+
+void ec_table_free(MewEcTable *t) {
+    if (!t) return;
+    free(t->points);
+    free(t);
+}
+
+MewPoint ec_mul_table(const MewEcTable *t, const Mew *k) {
+    if (!t || !k || k->chozabretto) return ec_point_error();
+    if (bit_len(k) > (t->windows - 1) * EC_COMB_BITS) return ec_point_error();
+
+    const MewCurve *c = &t->curve;
+    MewPoint r = ec_infinity();
+    int carry = 0;
+
+    for (int i = 0; i < t->windows; ++i) {
+        int d = (int)bits_at(k, i * EC_COMB_BITS, EC_COMB_BITS) + carry;
+        carry = d > EC_COMB_TABLE;
+        if (carry) d -= 1 << EC_COMB_BITS;
+        if (d == 0) continue;
+
+        const MewPoint *e = &t->points[(size_t)i * EC_COMB_TABLE + (size_t)(abs(d) - 1)];
+        if (d > 0) {
+            r = ec_add(c, &r, e);
+        } else {
+            MewPoint neg = ec_negate(c, e);
+            r = ec_add(c, &r, &neg);
+        }
+    }
+    return k->negative ? ec_negate(c, &r) : r;
+}
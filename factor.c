@@ -0,0 +1,490 @@
+#include "mew.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Factoring: Pollard rho with Brent's cycle finding, and ECM on Montgomery
+ * curves By^2 = x^3 + Ax^2 + x in XZ coordinates. Both run as a race: every
+ * worker gets its own random stream, the first one to hit a proper factor
+ * publishes it and raises a flag that the others poll, so the whole pool
+ * winds down together.
+ *
+ * All arithmetic goes through one MewMod context built before the workers
+ * start; contexts are read-only, so workers share it.
+ */
+
+#define RHO_BATCH     128      /* |x - y| products per gcd */
+#define ECM_D         210      /* stage 2 giant step, 2*3*5*7 */
+#define ECM_BABY      24       /* odd j < D/2 coprime to D */
+#define ECM_POLL      32       /* stage 1 primes between cancellation checks */
+
+typedef struct Race Race;
+typedef void (*RaceWork)(Race *race, MewRng *rng);
+
+struct Race {
+    Mew n;
+    MewMod m;
+    atomic_bool found;
+    atomic_int next_curve;
+    pthread_mutex_t lock;
+    Mew factor;
+
+    uint64_t seed;
+    uint64_t rho_iters;
+    uint32_t b1, b2;
+    int curves;
+    uint8_t *composite;        /* sieve over [0, b2] */
+    RaceWork work;
+};
+
+typedef struct {
+    Race *race;
+    int id;
+} RaceArg;
+
+typedef struct {
+    Mew x;
+    Mew z;
+} XZ;
+
+
+static Mew factor_error(void) {
+    Mew r = zero();
+    r.chozabretto = true;
+    return r;
+}
+
+static bool is_proper(const Mew *g, const Mew *n) {
+    Mew one = from_u32(1);
+    return !g->chozabretto && cmp(g, &one) > 0 && cmp(g, n) < 0;
+}
+
+static bool cancelled(Race *race) {
+    return atomic_load_explicit(&race->found, memory_order_relaxed);
+}
+
+static bool publish(Race *race, const Mew *g) {
+    if (!is_proper(g, &race->n)) return false;
+
+    pthread_mutex_lock(&race->lock);
+    if (!atomic_load(&race->found)) {
+        race->factor = *g;
+        atomic_store(&race->found, true);
+    }
+    pthread_mutex_unlock(&race->lock);
+    return true;
+}
+
+static void *race_thread(void *p) {
+    RaceArg *arg = p;
+    MewRng rng;
+    rng_seed(&rng, arg->race->seed, (uint64_t)arg->id);
+    arg->race->work(arg->race, &rng);
+    return NULL;
+}
+
+static Mew race_run(Race *race, int threads) {
+    if (threads < 1) threads = 1;
+
+    pthread_t *pool = malloc((size_t)threads * sizeof(pthread_t));
+    RaceArg *args = malloc((size_t)threads * sizeof(RaceArg));
+    if (!pool || !args) {
+        free(pool);
+        free(args);
+        return factor_error();
+    }
+
+    atomic_init(&race->found, false);
+    atomic_init(&race->next_curve, 0);
+    pthread_mutex_init(&race->lock, NULL);
+
+    int started = 0;
+    for (int i = 0; i < threads; ++i) {
+        args[i].race = race;
+        args[i].id = i;
+        if (pthread_create(&pool[i], NULL, race_thread, &args[i]) != 0) break;
+        ++started;
+    }
+    if (started == 0) race_thread(&args[0]);
+    for (int i = 0; i < started; ++i)
+        pthread_join(pool[i], NULL);
+
+    pthread_mutex_destroy(&race->lock);
+    free(pool);
+    free(args);
+    return atomic_load(&race->found) ? race->factor : factor_error();
+}
+
+static bool race_init(Race *race, const Mew *n, uint64_t seed) {
+    memset(race, 0, sizeof(*race));
+    if (!n || n->chozabretto || n->negative) return false;
+
+    Mew four = from_u32(4);
+    if (cmp(n, &four) < 0) return false;
+
+    race->n = *n;
+    race->m = mod_context(n);
+    race->seed = seed;
+    return !race->m.chozabretto;
+}
+
+
+/* ---- Pollard rho, Brent variant ---- */
+
+static Mew rho_step(const MewMod *m, const Mew *x, const Mew *c) {
+    Mew y = mod_square_ctx(m, x);
+    return mod_add_ctx(m, &y, c);
+}
+
+static Mew abs_diff(const Mew *a, const Mew *b) {
+    Mew d = sub(a, b);
+    d.negative = false;
+    return d;
+}
+
+static void rho_work(Race *race, MewRng *rng) {
+    const MewMod *m = &race->m;
+    Mew one = from_u32(1);
+    Mew two = from_u32(2);
+    Mew minus_two = sub(&race->n, &two);
+    uint64_t budget = race->rho_iters;
+
+    while (budget > 0 && !cancelled(race)) {
+        /* c = 0 and c = -2 give degenerate maps */
+        Mew c = random_below_r(rng, &race->n);
+        if (is_zero(&c) || cmp(&c, &minus_two) == 0) continue;
+
+        Mew y = random_below_r(rng, &race->n);
+        Mew x = y, ys = y;
+        Mew q = one, g = one;
+
+        for (uint64_t r = 1; cmp(&g, &one) == 0; r *= 2) {
+            if (budget < r || cancelled(race)) return;
+
+            x = y;
+            for (uint64_t i = 0; i < r; ++i) y = rho_step(m, &y, &c);
+            budget -= r;
+
+            for (uint64_t k = 0; k < r && cmp(&g, &one) == 0; k += RHO_BATCH) {
+                uint64_t lim = r - k < RHO_BATCH ? r - k : RHO_BATCH;
+                if (budget < lim || cancelled(race)) return;
+
+                ys = y;
+                for (uint64_t i = 0; i < lim; ++i) {
+                    y = rho_step(m, &y, &c);
+                    Mew d = abs_diff(&x, &y);
+                    q = mod_multiply_ctx(m, &q, &d);
+                }
+                budget -= lim;
+                g = gcd(&q, &race->n);
+            }
+        }
+
+        /* the batch overshot: replay it one gcd at a time */
+        if (cmp(&g, &race->n) == 0) {
+            do {
+                ys = rho_step(m, &ys, &c);
+                Mew d = abs_diff(&x, &ys);
+                g = gcd(&d, &race->n);
+            } while (cmp(&g, &one) == 0);
+        }
+
+        if (publish(race, &g)) return;
+    }
+}
+
+Mew factor_rho(const Mew *n, uint64_t max_iters, int threads, uint64_t seed) {
+    Race race;
+    if (!race_init(&race, n, seed)) return factor_error();
+    if (is_even(n)) return from_u32(2);
+
+    race.rho_iters = max_iters;
+    race.work = rho_work;
+    return race_run(&race, threads);
+}
+
+
+/* ---- ECM ---- */
+
+/* 2P, with a24 = (A + 2) / 4 */
+static XZ xdbl(const MewMod *m, const XZ *p, const Mew *a24) {
+    Mew s = mod_add_ctx(m, &p->x, &p->z);
+    Mew d = mod_subtract_ctx(m, &p->x, &p->z);
+    Mew s2 = mod_square_ctx(m, &s);
+    Mew d2 = mod_square_ctx(m, &d);
+    Mew t = mod_subtract_ctx(m, &s2, &d2);
+
+    XZ r;
+    r.x = mod_multiply_ctx(m, &s2, &d2);
+    Mew at = mod_multiply_ctx(m, a24, &t);
+    Mew u = mod_add_ctx(m, &d2, &at);
+    r.z = mod_multiply_ctx(m, &t, &u);
+    return r;
+}
+
+/* P + Q, given P - Q */
+static XZ xadd(const MewMod *m, const XZ *p, const XZ *q, const XZ *diff) {
+    Mew pd = mod_subtract_ctx(m, &p->x, &p->z);
+    Mew ps = mod_add_ctx(m, &p->x, &p->z);
+    Mew qd = mod_subtract_ctx(m, &q->x, &q->z);
+    Mew qs = mod_add_ctx(m, &q->x, &q->z);
+    Mew u = mod_multiply_ctx(m, &pd, &qs);
+    Mew v = mod_multiply_ctx(m, &ps, &qd);
+
+    Mew sum = mod_add_ctx(m, &u, &v);
+    Mew dif = mod_subtract_ctx(m, &u, &v);
+    Mew sum2 = mod_square_ctx(m, &sum);
+    Mew dif2 = mod_square_ctx(m, &dif);
+
+    XZ r;
+    r.x = mod_multiply_ctx(m, &diff->z, &sum2);
+    r.z = mod_multiply_ctx(m, &diff->x, &dif2);
+    return r;
+}
+
+/* [k]P by the Montgomery ladder, k >= 1 */
+static XZ ladder(const MewMod *m, const XZ *p, uint64_t k, const Mew *a24) {
+    XZ r0 = *p;
+    XZ r1 = xdbl(m, p, a24);
+
+    int top = 63;
+    while (top > 0 && !((k >> top) & 1)) --top;
+
+    for (int i = top - 1; i >= 0; --i) {
+        if ((k >> i) & 1) {
+            r0 = xadd(m, &r1, &r0, p);
+            r1 = xdbl(m, &r1, a24);
+        } else {
+            r1 = xadd(m, &r1, &r0, p);
+            r0 = xdbl(m, &r0, a24);
+        }
+    }
+    return r0;
+}
+
+static void sieve(uint8_t *composite, uint32_t limit) {
+    memset(composite, 0, (size_t)limit + 1);
+    composite[0] = composite[1] = 1;
+    for (uint64_t p = 2; p * p <= limit; ++p) {
+        if (composite[p]) continue;
+        for (uint64_t q = p * p; q <= limit; q += p) composite[q] = 1;
+    }
+}
+
+/*
+ * Suyama's parametrisation: sigma picks the curve and the starting point,
+ * which has a group order divisible by 12. Building a24 needs one inversion;
+ * when that fails the denominator may already share a factor with n.
+ */
+static bool ecm_curve(Race *race, MewRng *rng, XZ *p, Mew *a24) {
+    const MewMod *m = &race->m;
+    Mew six = from_u32(6);
+    Mew span = sub(&race->n, &six);
+    Mew sigma = random_below_r(rng, &span);
+    sigma = add(&sigma, &six);
+
+    Mew five = from_u32(5);
+    Mew four = from_u32(4);
+    Mew three = from_u32(3);
+    Mew sixteen = from_u32(16);
+
+    Mew u = mod_square_ctx(m, &sigma);
+    u = mod_subtract_ctx(m, &u, &five);
+    Mew v = mod_multiply_ctx(m, &four, &sigma);
+
+    Mew u2 = mod_square_ctx(m, &u);
+    Mew u3 = mod_multiply_ctx(m, &u2, &u);
+    Mew v2 = mod_square_ctx(m, &v);
+    Mew v3 = mod_multiply_ctx(m, &v2, &v);
+    p->x = u3;
+    p->z = v3;
+
+    Mew vu = mod_subtract_ctx(m, &v, &u);
+    Mew vu2 = mod_square_ctx(m, &vu);
+    Mew vu3 = mod_multiply_ctx(m, &vu2, &vu);
+    Mew u3v = mod_multiply_ctx(m, &three, &u);
+    u3v = mod_add_ctx(m, &u3v, &v);
+    Mew num = mod_multiply_ctx(m, &vu3, &u3v);
+
+    Mew den = mod_multiply_ctx(m, &sixteen, &u3);
+    den = mod_multiply_ctx(m, &den, &v);
+
+    Mew inv = mod_inverse_ctx(m, &den);
+    if (inv.chozabretto) {
+        Mew g = gcd(&den, &race->n);
+        publish(race, &g);
+        return false;
+    }
+    *a24 = mod_multiply_ctx(m, &num, &inv);
+    return true;
+}
+
+static bool ecm_stage1(Race *race, XZ *p, const Mew *a24) {
+    const MewMod *m = &race->m;
+    uint32_t b1 = race->b1;
+    int polled = 0;
+
+    for (uint32_t q = 2; q <= b1; ++q) {
+        if (race->composite[q]) continue;
+
+        uint64_t pe = q;
+        while (pe * q <= b1) pe *= q;
+        *p = ladder(m, p, pe, a24);
+
+        if (++polled == ECM_POLL) {
+            polled = 0;
+            if (cancelled(race)) return false;
+        }
+    }
+
+    Mew g = gcd(&p->z, &race->n);
+    if (publish(race, &g)) return false;
+    return !is_zero(&p->z);
+}
+
+static bool is_prime_in(const Race *race, uint64_t q) {
+    return q > race->b1 && q <= race->b2 && !race->composite[q];
+}
+
+/*
+ * Baby-step giant-step continuation: every prime q in (B1, B2] is m D +- j
+ * for an odd j < D/2 coprime to D. The baby points [j]Q are made affine with
+ * one batch inversion, so each prime costs a single multiplication into the
+ * accumulator, (X_T - x_j Z_T) for T = [m D]Q.
+ */
+static void ecm_stage2(Race *race, const XZ *q, const Mew *a24) {
+    const MewMod *m = &race->m;
+    XZ baby[ECM_BABY];
+    int baby_j[ECM_BABY];
+    int nb = 0;
+
+    XZ q2 = xdbl(m, q, a24);
+    XZ prev = *q, cur = *q;      /* [-1]Q has the same x as Q */
+    for (int j = 1; j < ECM_D / 2; j += 2) {
+        if (j % 3 && j % 5 && j % 7) {
+            baby[nb] = cur;
+            baby_j[nb] = j;
+            ++nb;
+        }
+        XZ next = xadd(m, &cur, &q2, &prev);
+        prev = cur;
+        cur = next;
+    }
+
+    Mew zs[ECM_BABY], xs[ECM_BABY], scratch[ECM_BABY];
+    for (int i = 0; i < nb; ++i) zs[i] = baby[i].z;
+    int bad = mod_batch_inverse(m, zs, zs, scratch, nb);
+    if (bad >= 0) {
+        Mew g = gcd(&baby[bad].z, &race->n);
+        publish(race, &g);
+        return;
+    }
+    if (bad != -1) return;
+    for (int i = 0; i < nb; ++i) xs[i] = mod_multiply_ctx(m, &baby[i].x, &zs[i]);
+
+    uint64_t m0 = race->b1 / ECM_D;
+    if (m0 < 1) m0 = 1;
+
+    XZ step = ladder(m, q, ECM_D, a24);
+    XZ t = ladder(m, q, m0 * ECM_D, a24);
+    XZ tn = ladder(m, q, (m0 + 1) * ECM_D, a24);
+    Mew acc = from_u32(1);
+
+    for (uint64_t k = m0; k * ECM_D <= (uint64_t)race->b2 + ECM_D / 2; ++k) {
+        uint64_t c = k * ECM_D;
+        for (int i = 0; i < nb; ++i) {
+            if (!is_prime_in(race, c - baby_j[i]) && !is_prime_in(race, c + baby_j[i])) continue;
+            Mew xz = mod_multiply_ctx(m, &xs[i], &t.z);
+            Mew d = mod_subtract_ctx(m, &t.x, &xz);
+            acc = mod_multiply_ctx(m, &acc, &d);
+        }
+        if (cancelled(race)) return;
+
+        XZ tnn = xadd(m, &tn, &step, &t);
+        t = tn;
+        tn = tnn;
+    }
+
+    Mew g = gcd(&acc, &race->n);
+    publish(race, &g);
+}
+
+static void ecm_work(Race *race, MewRng *rng) {
+    while (!cancelled(race)) {
+        int idx = atomic_fetch_add(&race->next_curve, 1);
+        if (idx >= race->curves) return;
+
+        XZ p;
+        Mew a24;
+        if (!ecm_curve(race, rng, &p, &a24)) continue;
+        if (!ecm_stage1(race, &p, &a24)) continue;
+        if (race->b2 > race->b1) ecm_stage2(race, &p, &a24);
+    }
+}
+
+Mew factor_ecm(const Mew *n, uint32_t b1, uint32_t b2, int curves, int threads, uint64_t seed) {
+    Race race;
+    if (!race_init(&race, n, seed) || b1 < 2 || curves < 1) return factor_error();
+    if (is_even(n)) return from_u32(2);
+    Mew seven = from_u32(7);
+    if (cmp(n, &seven) <= 0) return factor_error();
+    if (b2 < b1) b2 = b1;
+
+    race.composite = malloc((size_t)b2 + 1);
+    if (!race.composite) return factor_error();
+    sieve(race.composite, b2);
+
+    race.b1 = b1;
+    race.b2 = b2;
+    race.curves = curves;
+    race.work = ecm_work;
+    Mew r = race_run(&race, threads);
+
+    free(race.composite);
+    return r;
+}
+
+
+/* ---- driver ---- */
+
+static const struct {
+    uint32_t b1;
+    int curves;
+} ECM_LEVELS[] = {
+    {2000, 25}, {11000, 90}, {50000, 300}, {250000, 700},
+};
+
+/*
+ * One proper factor of n: trial division, perfect powers, then rho for small
+ * factors and ECM with growing B1. Errors when n is prime or nothing turned
+ * up within the last level.
+ */
+Mew factor_find(const Mew *n, int threads, uint64_t seed) {
+    Mew four = from_u32(4);
+    if (!n || n->chozabretto || n->negative || cmp(n, &four) < 0) return factor_error();
+    if (is_even(n)) return from_u32(2);
+
+    for (uint32_t p = 3; p < 1000; p += 2) {
+        Mew pm = from_u32(p);
+        if (cmp(&pm, n) >= 0) break;
+        Mew r = modm(n, &pm);
+        if (is_zero(&r)) return pm;
+    }
+
+    Mew root;
+    uint32_t k;
+    if (is_perfect_power(n, &root, &k)) return root;
+    if (baillie_psw(n)) return factor_error();
+
+    Mew g = factor_rho(n, 1u << 16, threads, seed);
+    if (!g.chozabretto) return g;
+
+    for (size_t i = 0; i < sizeof(ECM_LEVELS) / sizeof(ECM_LEVELS[0]); ++i) {
+        g = factor_ecm(n, ECM_LEVELS[i].b1, ECM_LEVELS[i].b1 * 100,
+                       ECM_LEVELS[i].curves, threads, seed + i + 1);
+        if (!g.chozabretto) return g;
+    }
+    return factor_error();
+}
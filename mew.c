@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "mew.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,10 +27,20 @@ Mew from_u32(uint32_t n) {
 }
 
 Mew from_hex(const char *hex) {
+    if (!hex) {
+        Mew res = zero();
+        res.chozabretto = true;
+        return res;
+    }
+    return from_hex_n(hex, strlen(hex));
+}
+
+/* parses exactly len characters, so tokens inside a larger buffer need no copy */
+Mew from_hex_n(const char *hex, size_t n) {
     Mew res = zero();
     if (!hex) { res.chozabretto = true; return res; }
 
-    int len = (int)strlen(hex);
+    int len = (int)n;
     for (int i = 0; i < len; ++i) {
         int d = hex_to_digit(hex[len - 1 - i]);
         if (d < 0) { res.chozabretto = true; return res; }
@@ -86,6 +98,45 @@ char *to_hex(const Mew *a) {
 
 
 
+/* writes the to_hex text into buf without allocating; returns its length, or -1 if cap is too small */
+int to_hex_buf(const Mew *a, char *buf, size_t cap) {
+    static const char digits[] = "0123456789abcdef";
+
+    if (!a || a->chozabretto) {
+        if (cap < 6) return -1;
+        memcpy(buf, "error", 6);
+        return 5;
+    }
+
+    int n = digit_len(a);
+    if (n == 0) {
+        if (cap < 2) return -1;
+        buf[0] = '0';
+        buf[1] = 0;
+        return 1;
+    }
+
+    uint32_t top = a->numberArray[n - 1];
+    int top_digits = 8;
+    while (!(top >> ((top_digits - 1) * 4))) --top_digits;
+
+    size_t len = (size_t)(n - 1) * 8 + top_digits;
+    if (cap < len + 1) return -1;
+
+    char *p = buf + len;
+    *p = 0;
+    for (int i = 0; i < n; ++i) {
+        uint32_t w = a->numberArray[i];
+        int cnt = i == n - 1 ? top_digits : 8;
+        for (int j = 0; j < cnt; ++j) {
+            *--p = digits[w & 0xF];
+            w >>= 4;
+        }
+    }
+    return (int)len;
+}
+
+
 Mew copy(const Mew *a) {
     Mew r = zero();
     memcpy(r.numberArray, a->numberArray, sizeof(a->numberArray));
@@ -267,53 +318,659 @@ Mew mul_one(const Mew *a, uint32_t b) {
     return r;
 }
 
-Mew mul(const Mew *a, const Mew *b) {
+/*
+ * Limb-level kernels. Operands are little-endian uint32_t runs of an explicit
+ * length, so the work scales with the significant digits instead of NUM_LEN.
+ */
+
+#define KARATSUBA_THRESHOLD 24
+/* Karatsuba levels at least this many limbs wide hand their three products to the pool */
+#define PAR_MUL_THRESHOLD   96
+#define PAR_MUL_DEPTH       2
+#define BZ_THRESHOLD        32
+/* up to this many limbs mu is divided out; past it Newton on the top half costs no more than BZ */
+#define RECIP_THRESHOLD     48
+
+#define WORDS_MAX (4 * NUM_LEN)
+
+/* r = a + b, na >= nb, r has na limbs (may alias a); returns the carry */
+static uint32_t add_words(uint32_t *r, const uint32_t *a, int na, const uint32_t *b, int nb) {
+    uint64_t carry = 0;
+    int i = 0;
+    for (; i < nb; ++i) {
+        uint64_t sum = (uint64_t)a[i] + b[i] + carry;
+        r[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    for (; i < na; ++i) {
+        uint64_t sum = (uint64_t)a[i] + carry;
+        r[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    return (uint32_t)carry;
+}
+
+/* r = a - b, na >= nb, r has na limbs (may alias a); returns the borrow */
+static uint32_t sub_words(uint32_t *r, const uint32_t *a, int na, const uint32_t *b, int nb) {
+    uint32_t borrow = 0;
+    int i = 0;
+    for (; i < nb; ++i) {
+        uint64_t diff = (uint64_t)a[i] - b[i] - borrow;
+        r[i] = (uint32_t)diff;
+        borrow = (uint32_t)(diff >> 63);
+    }
+    for (; i < na; ++i) {
+        uint64_t diff = (uint64_t)a[i] - borrow;
+        r[i] = (uint32_t)diff;
+        borrow = (uint32_t)(diff >> 63);
+    }
+    return borrow;
+}
+
+static int cmp_words(const uint32_t *a, const uint32_t *b, int n) {
+    for (int i = n - 1; i >= 0; --i) {
+        if (a[i] > b[i]) return 1;
+        if (a[i] < b[i]) return -1;
+    }
+    return 0;
+}
+
+/* r = a * b, r has na + nb limbs and must not alias the inputs */
+static void mul_basecase(uint32_t *r, const uint32_t *a, int na, const uint32_t *b, int nb) {
+    memset(r, 0, (size_t)(na + nb) * sizeof(uint32_t));
+    for (int j = 0; j < nb; ++j) {
+        uint64_t bj = b[j];
+        if (!bj) continue;
+        uint64_t carry = 0;
+        for (int i = 0; i < na; ++i) {
+            uint64_t t = a[i] * bj + r[i + j] + carry;
+            r[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        r[j + na] = (uint32_t)carry;
+    }
+}
+
+/* r (2n limbs) = a * b, both n limbs; scratch needs about 4n limbs */
+static void karatsuba(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t *scratch) {
+    if (n < KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, n, b, n);
+        return;
+    }
+
+    int lo = n / 2, hi = n - lo;
+    uint32_t *sa = scratch;
+    uint32_t *sb = sa + hi + 1;
+    uint32_t *z1 = sb + hi + 1;
+    uint32_t *next = z1 + 2 * (hi + 1);
+
+    sa[hi] = add_words(sa, a + lo, hi, a, lo);
+    sb[hi] = add_words(sb, b + lo, hi, b, lo);
+
+    karatsuba(r, a, b, lo, next);
+    karatsuba(r + 2 * lo, a + lo, b + lo, hi, next);
+    karatsuba(z1, sa, sb, hi + 1, next);
+
+    sub_words(z1, z1, 2 * hi + 2, r, 2 * lo);
+    sub_words(z1, z1, 2 * hi + 2, r + 2 * lo, 2 * hi);
+    add_words(r + lo, r + lo, 2 * n - lo, z1, 2 * hi + 2);
+}
+
+typedef struct {
+    uint32_t *r;
+    const uint32_t *a;
+    const uint32_t *b;
+    int n;
+    int depth;
+} KaratsubaTask;
+
+static void karatsuba_par(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t *scratch, int depth);
+
+static void karatsuba_task(void *arg) {
+    KaratsubaTask *t = arg;
+    uint32_t scratch[6 * NUM_LEN + 128];
+    karatsuba_par(t->r, t->a, t->b, t->n, scratch, t->depth);
+}
+
+/*
+ * karatsuba with the three half-size products run as pool tasks. Each task
+ * writes a disjoint part of r or z1 and has its own scratch; the combine
+ * step waits for all three. Narrow levels, deep levels and a one-thread pool
+ * fall through to the serial code.
+ */
+static void karatsuba_par(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t *scratch, int depth) {
+    if (n < PAR_MUL_THRESHOLD || depth >= PAR_MUL_DEPTH || pool_threads() <= 1) {
+        karatsuba(r, a, b, n, scratch);
+        return;
+    }
+
+    int lo = n / 2, hi = n - lo;
+    uint32_t *sa = scratch;
+    uint32_t *sb = sa + hi + 1;
+    uint32_t *z1 = sb + hi + 1;
+
+    sa[hi] = add_words(sa, a + lo, hi, a, lo);
+    sb[hi] = add_words(sb, b + lo, hi, b, lo);
+
+    KaratsubaTask args[3] = {
+        {r, a, b, lo, depth + 1},
+        {r + 2 * lo, a + lo, b + lo, hi, depth + 1},
+        {z1, sa, sb, hi + 1, depth + 1},
+    };
+    MewTask tasks[3];
+    for (int i = 0; i < 3; ++i) {
+        tasks[i].fn = karatsuba_task;
+        tasks[i].arg = &args[i];
+    }
+    pool_run(tasks, 3);
+
+    sub_words(z1, z1, 2 * hi + 2, r, 2 * lo);
+    sub_words(z1, z1, 2 * hi + 2, r + 2 * lo, 2 * hi);
+    add_words(r + lo, r + lo, 2 * n - lo, z1, 2 * hi + 2);
+}
+
+/* r = a * b for arbitrary lengths; r has na + nb limbs and must not alias the inputs */
+static void mul_words(uint32_t *r, const uint32_t *a, int na, const uint32_t *b, int nb) {
+    if (na < nb) {
+        const uint32_t *t = a; a = b; b = t;
+        int tn = na; na = nb; nb = tn;
+    }
+    if (nb == 0) {
+        memset(r, 0, (size_t)na * sizeof(uint32_t));
+        return;
+    }
+    if (nb < KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, na, b, nb);
+        return;
+    }
+
+    uint32_t scratch[6 * NUM_LEN + 128];
+    if (na == nb) {
+        karatsuba_par(r, a, b, nb, scratch, 0);
+        return;
+    }
+
+    /* unbalanced: slice the long operand into nb-limb pieces */
+    uint32_t part[2 * NUM_LEN];
+    memset(r, 0, (size_t)(na + nb) * sizeof(uint32_t));
+    for (int off = 0; off < na; off += nb) {
+        int len = na - off < nb ? na - off : nb;
+        if (len == nb) karatsuba_par(part, a + off, b, nb, scratch, 0);
+        else mul_words(part, b, nb, a + off, len);
+        add_words(r + off, r + off, na + nb - off, part, len + nb);
+    }
+}
+
+/*
+ * Views: a limb run owned by someone else (a MewPack, a Mew, a mapped file).
+ * The limb kernels only need a pointer and a length, so arithmetic on views
+ * skips unpacking into a full Mew.
+ */
+MewView view_of(const Mew *a) {
+    MewView v;
+    v.limbs = a->numberArray;
+    v.len = digit_len(a);
+    v.negative = a->negative;
+    return v;
+}
+
+static int view_len(const MewView *v) {
+    int n = v->len;
+    while (n > 0 && !v->limbs[n - 1]) --n;
+    return n;
+}
+
+Mew from_view(const MewView *v) {
     Mew r = zero();
-    for (int i = 0; i < NUM_LEN; ++i) {
-        if (!b->numberArray[i]) continue;
-        Mew t = mul_one(a, b->numberArray[i]);
-        Mew s = shift_digits_high(&t, i);
-        r = add(&r, &s);
-        if (r.chozabretto) break;
+    int n = view_len(v);
+    if (n > NUM_LEN) { r.chozabretto = true; return r; }
+    memcpy(r.numberArray, v->limbs, (size_t)n * sizeof(uint32_t));
+    r.negative = v->negative && n > 0;
+    return r;
+}
+
+int cmp_view(const MewView *a, const MewView *b) {
+    int na = view_len(a), nb = view_len(b);
+    if (na != nb) return na > nb ? 1 : -1;
+    return cmp_words(a->limbs, b->limbs, na);
+}
+
+Mew add_view(const MewView *a, const MewView *b) {
+    Mew r = zero();
+    int na = view_len(a), nb = view_len(b);
+    if (na > NUM_LEN || nb > NUM_LEN) { r.chozabretto = true; return r; }
+
+    const uint32_t *x = a->limbs, *y = b->limbs;
+    if (na < nb) {
+        const uint32_t *t = x; x = y; y = t;
+        int tn = na; na = nb; nb = tn;
+    }
+    uint32_t carry = add_words(r.numberArray, x, na, y, nb);
+    if (carry) {
+        if (na < NUM_LEN) r.numberArray[na] = carry;
+        else r.chozabretto = true;
     }
     return r;
 }
 
+Mew mul_view(const MewView *a, const MewView *b) {
+    Mew r = zero();
+    int na = view_len(a), nb = view_len(b);
+    if (na > NUM_LEN || nb > NUM_LEN) { r.chozabretto = true; return r; }
+    if (!na || !nb) return r;
+
+    uint32_t t[2 * NUM_LEN];
+    mul_words(t, a->limbs, na, b->limbs, nb);
+
+    for (int i = 0; i < na + nb; ++i) {
+        if (i < NUM_LEN) r.numberArray[i] = t[i];
+        else if (t[i]) r.chozabretto = true;
+    }
+    return r;
+}
+
+Mew mul(const Mew *a, const Mew *b) {
+    if (a->chozabretto || b->chozabretto) {
+        Mew r = zero();
+        r.chozabretto = true;
+        return r;
+    }
+    MewView va = view_of(a), vb = view_of(b);
+    return mul_view(&va, &vb);
+}
+
 Mew sqr(const Mew *a) { return mul(a, a); }
 
-static void set_bit(Mew *q, int bit) {
-    if (bit < 0) return;
-    int idx = bit / 32, sh = bit % 32;
-    if (idx < NUM_LEN) q->numberArray[idx] |= (1u << sh);
+static int clz32(uint32_t x) {
+    int n = 0;
+    while (!(x & 0x80000000u)) { x <<= 1; ++n; }
+    return n;
 }
 
-Mew divm(const Mew *num, const Mew *den) {
+/*
+ * Knuth algorithm D. u has n + m limbs and its top n limbs are below v, so the
+ * quotient fits in m limbs; v is normalized (top bit set), n >= 2. The
+ * remainder is left in u[0..n), the rest of u is cleared.
+ */
+static void div_basecase(uint32_t *q, uint32_t *u, int m, const uint32_t *v, int n) {
+    const uint64_t b = 1ull << 32;
+    for (int j = m - 1; j >= 0; --j) {
+        uint64_t num = ((uint64_t)u[j + n] << 32) | u[j + n - 1];
+        uint64_t qhat = num / v[n - 1];
+        uint64_t rhat = num - qhat * v[n - 1];
+        while (qhat >= b || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2])) {
+            --qhat;
+            rhat += v[n - 1];
+            if (rhat >= b) break;
+        }
+
+        int64_t k = 0, t;
+        for (int i = 0; i < n; ++i) {
+            uint64_t p = qhat * v[i];
+            t = (int64_t)u[i + j] - k - (int64_t)(p & 0xFFFFFFFFu);
+            u[i + j] = (uint32_t)t;
+            k = (int64_t)(p >> 32) - (t >> 32);
+        }
+        t = (int64_t)u[j + n] - k;
+        u[j + n] = (uint32_t)t;
+
+        q[j] = (uint32_t)qhat;
+        if (t < 0) {
+            --q[j];
+            u[j + n] += add_words(u + j, u + j, n, v, n);
+        }
+    }
+}
+
+static void div2n1n(uint32_t *q, uint32_t *z, const uint32_t *b, int n);
+
+/*
+ * Burnikel-Ziegler 3h/2h step: z has 3h limbs and z < b * B^h. Leaves the
+ * remainder in z[0..2h) and the h-limb quotient in q.
+ */
+static void div3n2n(uint32_t *q, uint32_t *z, const uint32_t *b, int h) {
+    if (cmp_words(z + 2 * h, b + h, h) < 0) {
+        div2n1n(q, z + h, b + h, h);
+    } else {
+        /* top limbs equal: the quotient saturates at B^h - 1 */
+        for (int i = 0; i < h; ++i) q[i] = 0xFFFFFFFFu;
+        memset(z + 2 * h, 0, (size_t)h * sizeof(uint32_t));
+        add_words(z + h, z + h, 2 * h, b + h, h);
+    }
+
+    uint32_t d[2 * NUM_LEN];
+    mul_words(d, q, h, b, h);
+
+    uint32_t borrow = sub_words(z, z, 3 * h, d, 2 * h);
+    while (borrow) {
+        uint32_t one = 1;
+        sub_words(q, q, h, &one, 1);
+        if (add_words(z, z, 3 * h, b, 2 * h)) borrow = 0;
+    }
+}
+
+/* z has 2n limbs and z < b * B^n; remainder lands in z[0..n), quotient in q[0..n) */
+static void div2n1n(uint32_t *q, uint32_t *z, const uint32_t *b, int n) {
+    if ((n & 1) || n <= BZ_THRESHOLD) {
+        div_basecase(q, z, n, b, n);
+        return;
+    }
+    int h = n / 2;
+    div3n2n(q + h, z + h, b, h);
+    div3n2n(q, z, b, h);
+}
+
+/*
+ * q (na - nb + 1 limbs) = a / b, r (nb limbs) = a % b, with b[nb - 1] != 0.
+ * Short divisors take Knuth D; long ones go through Burnikel-Ziegler, which
+ * costs a small multiple of a Karatsuba multiplication.
+ */
+static void divmod_words(uint32_t *q, uint32_t *r, const uint32_t *a, int na, const uint32_t *b, int nb) {
+    int m = na - nb + 1;
+    memset(q, 0, (size_t)m * sizeof(uint32_t));
+
+    if (nb == 1) {
+        uint64_t rem = 0;
+        for (int i = na - 1; i >= 0; --i) {
+            uint64_t cur = (rem << 32) | a[i];
+            q[i] = (uint32_t)(cur / b[0]);
+            rem = cur % b[0];
+        }
+        r[0] = (uint32_t)rem;
+        return;
+    }
+
+    /* pad the divisor to j * 2^k limbs so every BZ level halves evenly */
+    int nn = nb, pad = 0;
+    if (nb > BZ_THRESHOLD && m > BZ_THRESHOLD) {
+        int j = nb, k = 0;
+        while (j > BZ_THRESHOLD) { j = (j + 1) / 2; ++k; }
+        nn = j << k;
+        pad = nn - nb;
+    }
+
+    int s = clz32(b[nb - 1]);
+    uint32_t bn[WORDS_MAX] = {0};
+    uint32_t an[WORDS_MAX] = {0};
+    for (int i = 0; i < nb; ++i)
+        bn[pad + i] = (b[i] << s) | (s && i ? b[i - 1] >> (32 - s) : 0);
+    for (int i = 0; i <= na; ++i) {
+        uint32_t lo = (s && i ? a[i - 1] >> (32 - s) : 0);
+        an[pad + i] = (i < na ? a[i] << s : 0) | lo;
+    }
+    int len = pad + na + 1;
+
+    if (nn == nb) {
+        div_basecase(q, an, m, bn, nb);
+    } else {
+        int t = (len + nn - 1) / nn;
+        if (t < 2) t = 2;
+        if (cmp_words(an + (t - 1) * nn, bn, nn) >= 0) ++t;
+
+        uint32_t z[WORDS_MAX];
+        uint32_t qb[WORDS_MAX];
+        memcpy(z, an + (t - 2) * nn, (size_t)(2 * nn) * sizeof(uint32_t));
+        for (int i = t - 2; i >= 0; --i) {
+            div2n1n(qb, z, bn, nn);
+            for (int j = 0; j < nn && i * nn + j < m; ++j)
+                q[i * nn + j] = qb[j];
+            if (i > 0) {
+                memcpy(z + nn, z, (size_t)nn * sizeof(uint32_t));
+                memcpy(z, an + (i - 1) * nn, (size_t)nn * sizeof(uint32_t));
+            }
+        }
+        memcpy(an, z, (size_t)nn * sizeof(uint32_t));
+        an[nn] = 0;
+    }
+
+    for (int i = 0; i < nb; ++i)
+        r[i] = (an[pad + i] >> s) | (s ? an[pad + i + 1] << (32 - s) : 0);
+}
+
+Mew divmod(const Mew *num, const Mew *den, Mew *rem) {
     Mew q = zero();
-    if (is_zero(den)) { q.chozabretto = true; return q; }
-
-    Mew rem = copy(num);
-    Mew d = copy(den);
-    int s = bit_len(&rem) - bit_len(&d);
-    if (s < 0) return q;
-
-    Mew sh = shift_left(&d, s);
-    for (int i = s; i >= 0; --i) {
-        if (cmp(&rem, &sh) >= 0) {
-            rem = sub(&rem, &sh);
-            set_bit(&q, i);
+    if (rem) *rem = zero();
+    if (is_zero(den)) {
+        q.chozabretto = true;
+        if (rem) rem->chozabretto = true;
+        return q;
+    }
+
+    int na = digit_len(num), nb = digit_len(den);
+    if (cmp(num, den) < 0) {
+        if (rem) {
+            *rem = copy(num);
+            rem->negative = false;
         }
-        sh = shift_right(&sh, 1);
+        return q;
     }
+
+    uint32_t qw[NUM_LEN + 1], rw[NUM_LEN];
+    divmod_words(qw, rw, num->numberArray, na, den->numberArray, nb);
+    memcpy(q.numberArray, qw, (size_t)(na - nb + 1) * sizeof(uint32_t));
+    if (rem) memcpy(rem->numberArray, rw, (size_t)nb * sizeof(uint32_t));
     return q;
 }
 
+Mew divm(const Mew *num, const Mew *den) {
+    return divmod(num, den, NULL);
+}
+
+/*
+ * x (k + 2 limbs) = floor(B^(2k) / d) for a k-limb d with a nonzero top limb.
+ * y = floor(B^(2h) / dh) for the top h limbs dh of d gives x0 = y B^l to about
+ * h limbs. One Newton step x0 + x0 (B^(2k) - d x0) / B^(2k) doubles that; both
+ * of its products involve y or the short error, never a full k x k product.
+ * A last product d x confirms the floor, and is off by at most a few units.
+ */
+static void recip_words(uint32_t *x, const uint32_t *d, int k) {
+    int n = 2 * k + 2;
+    uint32_t beta[WORDS_MAX] = {0};
+    beta[2 * k] = 1;
+
+    uint32_t t[WORDS_MAX], e[WORDS_MAX], q[WORDS_MAX], r[WORDS_MAX];
+    if (k <= RECIP_THRESHOLD) {
+        divmod_words(q, r, beta, 2 * k + 1, d, k);
+        memcpy(x, q, (size_t)(k + 2) * sizeof(uint32_t));
+        return;
+    }
+
+    int h = (k + 1) / 2, l = k - h;
+    uint32_t y[NUM_LEN + 2];
+    recip_words(y, d + l, h);
+    int ny = h + 2;
+    while (ny > 0 && !y[ny - 1]) --ny;
+
+    /* e = |B^(2k) - d y B^l| */
+    memset(t, 0, (size_t)n * sizeof(uint32_t));
+    mul_words(t + l, d, k, y, ny);
+    bool over = cmp_words(t, beta, n) > 0;
+    if (over) sub_words(e, t, n, beta, n);
+    else sub_words(e, beta, n, t, n);
+
+    /* x = y B^l -+ y (e >> (k - 1) limbs) >> (h + 1) limbs */
+    memset(x, 0, (size_t)(k + 2) * sizeof(uint32_t));
+    memcpy(x + l, y, (size_t)ny * sizeof(uint32_t));
+    int nt = k + 3;
+    while (nt > 0 && !e[k - 1 + nt - 1]) --nt;
+    if (nt) {
+        memset(t, 0, (size_t)(ny + nt + h + 1) * sizeof(uint32_t));
+        mul_words(t, y, ny, e + k - 1, nt);
+        int nc = ny + nt - (h + 1);
+        if (nc > 0) {
+            if (over) sub_words(x, x, k + 2, t + h + 1, nc);
+            else add_words(x, x, k + 2, t + h + 1, nc);
+        }
+    }
+
+    /* settle the last units against d x */
+    mul_words(t, d, k, x, k + 2);
+    over = cmp_words(t, beta, n) > 0;
+    if (over) sub_words(e, t, n, beta, n);
+    else sub_words(e, beta, n, t, n);
+    int ne = n;
+    while (ne > 0 && !e[ne - 1]) --ne;
+
+    uint32_t one = 1;
+    if (ne < k || (ne == k && cmp_words(e, d, k) < 0)) {
+        if (over && ne) sub_words(x, x, k + 2, &one, 1);
+        return;
+    }
+    divmod_words(q, r, e, ne, d, k);
+    int nq = ne - k + 1;
+    if (over) {
+        int nr = k;
+        while (nr > 0 && !r[nr - 1]) --nr;
+        if (nr) add_words(q, q, nq, &one, 1);
+        sub_words(x, x, k + 2, q, nq);
+    } else {
+        add_words(x, x, k + 2, q, nq);
+    }
+}
+
+/* floor(B^(2k) / d) with k = digit_len(d), i.e. the Barrett mu */
+Mew reciprocal(const Mew *d) {
+    Mew r = zero();
+    int k = digit_len(d);
+    if (k == 0 || 2 * k >= NUM_LEN) { r.chozabretto = true; return r; }
+
+    recip_words(r.numberArray, d->numberArray, k);
+    return r;
+}
+
 Mew powm(const Mew *base, const Mew *exp) {
     Mew r = from_u32(1);
     Mew b = copy(base);
     int n = bit_len(exp);
-    for (int i = 0; i < n; ++i) {
+    for (int i = 0; i < n && !r.chozabretto; ++i) {
         if (bit_at(exp, i)) r = mul(&r, &b);
-        b = mul(&b, &b);
+        /* b is not needed past the top bit, so an overflow there is harmless */
+        if (i + 1 < n) b = mul(&b, &b);
     }
     return r;
 }
+
+
+static Mew div_word(const Mew *a, uint32_t d, uint32_t *rem) {
+    Mew q = zero();
+    uint64_t r = 0;
+    for (int i = digit_len(a) - 1; i >= 0; --i) {
+        uint64_t cur = (r << 32) | a->numberArray[i];
+        q.numberArray[i] = (uint32_t)(cur / d);
+        r = cur % d;
+    }
+    if (rem) *rem = (uint32_t)r;
+    return q;
+}
+
+static uint32_t mod_word(const Mew *a, uint32_t d) {
+    uint64_t r = 0;
+    for (int i = digit_len(a) - 1; i >= 0; --i)
+        r = ((r << 32) | a->numberArray[i]) % d;
+    return (uint32_t)r;
+}
+
+static Mew pow2(int bits) {
+    Mew r = from_u32(1);
+    return shift_left(&r, bits);
+}
+
+/* Newton iteration from 2^ceil(bits/2), which is never below the root, so it decreases monotonically */
+Mew isqrt(const Mew *a) {
+    Mew r = zero();
+    if (!a || a->chozabretto) { r.chozabretto = true; return r; }
+    if (is_zero(a)) return r;
+
+    Mew x = pow2((bit_len(a) + 1) / 2);
+    for (;;) {
+        Mew q = divm(a, &x);
+        Mew y = add(&x, &q);
+        y = shift_right(&y, 1);
+        if (cmp(&y, &x) >= 0) return x;
+        x = y;
+    }
+}
+
+Mew iroot(const Mew *a, uint32_t k) {
+    Mew r = zero();
+    if (!a || a->chozabretto || k == 0) { r.chozabretto = true; return r; }
+    if (k == 1) return copy(a);
+    if (k == 2) return isqrt(a);
+    if (is_zero(a)) return r;
+
+    int bits = bit_len(a);
+    if ((uint32_t)bits <= k) return from_u32(1);
+
+    Mew x = pow2((int)((bits + k - 1) / k));
+    Mew km1 = from_u32(k - 1);
+    for (;;) {
+        Mew t = powm(&x, &km1);
+        Mew q = zero();
+        if (!t.chozabretto) q = divm(a, &t);
+
+        Mew y = mul_one(&x, k - 1);
+        y = add(&y, &q);
+        y = div_word(&y, k, NULL);
+        if (cmp(&y, &x) >= 0) return x;
+        x = y;
+    }
+}
+
+static bool is_residue_mod(uint32_t r, uint32_t m) {
+    for (uint32_t i = 0; i <= m / 2; ++i)
+        if ((i * i) % m == r) return true;
+    return false;
+}
+
+/* 64 * 63 * 65 * 11: rejects all but ~1.5% of non-squares before any root is taken */
+#define SQUARE_FILTER_MOD 2882880u
+
+bool is_square(const Mew *a) {
+    if (!a || a->chozabretto) return false;
+    if (is_zero(a)) return true;
+
+    uint32_t r = mod_word(a, SQUARE_FILTER_MOD);
+    if (!is_residue_mod(r % 64, 64)) return false;
+    if (!is_residue_mod(r % 63, 63)) return false;
+    if (!is_residue_mod(r % 65, 65)) return false;
+    if (!is_residue_mod(r % 11, 11)) return false;
+
+    Mew s = isqrt(a);
+    Mew s2 = sqr(&s);
+    return cmp(&s2, a) == 0;
+}
+
+static bool is_small_prime(uint32_t p) {
+    if (p < 2) return false;
+    for (uint32_t d = 2; d * d <= p; ++d)
+        if (p % d == 0) return false;
+    return true;
+}
+
+/* a == root^k for some k >= 2; reports the smallest such prime k */
+bool is_perfect_power(const Mew *a, Mew *root, uint32_t *k) {
+    if (!a || a->chozabretto) return false;
+    Mew one = from_u32(1);
+    if (cmp(a, &one) <= 0) return false;
+
+    if (is_square(a)) {
+        if (root) *root = isqrt(a);
+        if (k) *k = 2;
+        return true;
+    }
+
+    int bits = bit_len(a);
+    for (uint32_t p = 3; p < (uint32_t)bits; p += 2) {
+        if (!is_small_prime(p)) continue;
+
+        Mew x = iroot(a, p);
+        Mew e = from_u32(p);
+        Mew xp = powm(&x, &e);
+        if (cmp(&xp, a) == 0) {
+            if (root) *root = x;
+            if (k) *k = p;
+            return true;
+        }
+    }
+    return false;
+}
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define NUM_LEN 256
 
@@ -12,13 +13,103 @@ typedef struct {
     bool chozabretto;
 } Mew;
 
+typedef struct {
+    const uint32_t *limbs;
+    int len;
+    bool negative;
+} MewView;
+
+typedef struct MewPack MewPack;
+typedef struct MewTable MewTable;
+
+typedef struct {
+    uint64_t s[4];
+} MewRng;
+
+typedef struct MewProgram MewProgram;
+
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+} MewTask;
+
+typedef enum {
+    MOD_GENERIC,
+    MOD_PSEUDO_MERSENNE,
+    MOD_SOLINAS
+} ModForm;
+
+#define SOLINAS_MAX_TERMS 8
+
+typedef struct {
+    Mew n;
+    Mew n2;
+    Mew n4;
+    Mew mu;
+    ModForm form;
+    int bits;
+    int nterms;
+    int term_shift[SOLINAS_MAX_TERMS];
+    int term_sign[SOLINAS_MAX_TERMS];
+    uint32_t term_mult[SOLINAS_MAX_TERMS];
+    bool chozabretto;
+} MewMod;
+
+typedef enum {
+    SQRT_3MOD4,
+    SQRT_5MOD8,
+    SQRT_TONELLI
+} SqrtKind;
+
+typedef struct {
+    MewMod m;
+    SqrtKind kind;
+    Mew exp;
+    Mew z;
+    int s;
+    bool chozabretto;
+} MewSqrt;
+
+typedef struct {
+    MewMod f;
+    Mew a;
+    Mew b;
+    Mew b3;
+    Mew gx;
+    Mew gy;
+    Mew order;
+    bool chozabretto;
+} MewCurve;
+
+typedef struct {
+    Mew x;
+    Mew y;
+    Mew z;
+} MewPoint;
+
+typedef struct MewEcTable MewEcTable;
+
+#define RNS_MAX_BITS     4032
+#define RNS_MAX_CHANNELS 136
+
+typedef struct {
+    uint32_t a[RNS_MAX_CHANNELS];
+    uint32_t b[RNS_MAX_CHANNELS];
+    uint32_t r;
+    bool chozabretto;
+} MewRnsValue;
+
+typedef struct MewRns MewRns;
+
 
 Mew      zero(void);
 Mew      newm(void);
 Mew      from_u32(uint32_t n);
 Mew      from_hex(const char *hex);
+Mew      from_hex_n(const char *hex, size_t len);
 
 char*    to_hex(const Mew *a);
+int      to_hex_buf(const Mew *a, char *buf, size_t cap);
 
 Mew      copy(const Mew *a);
 bool     is_zero(const Mew *a);
@@ -40,13 +131,27 @@ Mew mul_one(const Mew *a, uint32_t b);
 Mew mul(const Mew *a, const Mew *b);
 Mew sqr(const Mew *a);
 
+MewView view_of(const Mew *a);
+Mew     from_view(const MewView *v);
+int     cmp_view(const MewView *a, const MewView *b);
+Mew     add_view(const MewView *a, const MewView *b);
+Mew     mul_view(const MewView *a, const MewView *b);
+
 Mew divm(const Mew *num, const Mew *den);
+Mew divmod(const Mew *num, const Mew *den, Mew *rem);
+Mew reciprocal(const Mew *d);
 Mew modm(const Mew *num, const Mew *den);
 
 Mew powm(const Mew *base, const Mew *exp);
 
+Mew  isqrt(const Mew *a);
+Mew  iroot(const Mew *a, uint32_t k);
+bool is_square(const Mew *a);
+bool is_perfect_power(const Mew *a, Mew *root, uint32_t *k);
+
 Mew gcd(const Mew *a, const Mew *b);
 Mew lcm(const Mew *a, const Mew *b);
+Mew mod_inverse(const Mew *a, const Mew *mod);
 
 Mew modm(const Mew *a, const Mew *mod);
 Mew mod_add(const Mew *a, const Mew *b, const Mew *mod);
@@ -58,5 +163,109 @@ Mew barrett_reduction(const Mew *x, const Mew *mod, const Mew *mu);
 Mew mod_multiply(const Mew *a, const Mew *b, const Mew *mod);
 Mew mod_square(const Mew *a, const Mew *mod);
 Mew mod_pow_barrett(const Mew *base, const Mew *exp, const Mew *mod);
+Mew mod_multi_pow(const Mew *bases, const Mew *exps, int k, const Mew *mod);
+
+bool miller_rabin(const Mew *n, int rounds);
+int  jacobi(const Mew *a, const Mew *n);
+bool lucas_strong(const Mew *n);
+bool baillie_psw(const Mew *n);
+
+MewSqrt sqrt_context(const MewMod *m);
+bool    mod_sqrt_ctx(const MewSqrt *c, const Mew *a, Mew *root);
+Mew     mod_sqrt(const Mew *a, const Mew *p);
+
+MewMod mod_context(const Mew *mod);
+MewMod mod_context_special(int bits, const Mew *c);
+Mew    mod_reduce(const MewMod *m, const Mew *x);
+Mew    mod_multiply_ctx(const MewMod *m, const Mew *a, const Mew *b);
+Mew    mod_square_ctx(const MewMod *m, const Mew *a);
+Mew    mod_pow_ctx(const MewMod *m, const Mew *base, const Mew *exp);
+Mew    mod_add_ctx(const MewMod *m, const Mew *a, const Mew *b);
+Mew    mod_subtract_ctx(const MewMod *m, const Mew *a, const Mew *b);
+Mew    mod_multiply_view(const MewMod *m, const MewView *a, const MewView *b);
+Mew    mod_inverse_ctx(const MewMod *m, const Mew *a);
+int    mod_batch_inverse(const MewMod *m, const Mew *in, Mew *out, Mew *scratch, int k);
+
+Mew    mod_add_lazy(const MewMod *m, const Mew *a, const Mew *b);
+Mew    mod_subtract_lazy(const MewMod *m, const Mew *a, const Mew *b);
+Mew    mod_normalize_lazy(const MewMod *m, const Mew *a);
+
+Mew factor_rho(const Mew *n, uint64_t max_iters, int threads, uint64_t seed);
+Mew factor_ecm(const Mew *n, uint32_t b1, uint32_t b2, int curves, int threads, uint64_t seed);
+Mew factor_find(const Mew *n, int threads, uint64_t seed);
+
+MewCurve    ec_curve(const Mew *p, const Mew *a, const Mew *b);
+MewCurve    ec_curve_p256(void);
+MewCurve    ec_curve_secp256k1(void);
+MewPoint    ec_infinity(void);
+MewPoint    ec_point(const MewCurve *c, const Mew *x, const Mew *y);
+MewPoint    ec_generator(const MewCurve *c);
+bool        ec_is_infinity(const MewPoint *p);
+bool        ec_on_curve(const MewCurve *c, const MewPoint *p);
+bool        ec_equal(const MewCurve *c, const MewPoint *p, const MewPoint *q);
+bool        ec_to_affine(const MewCurve *c, const MewPoint *p, Mew *x, Mew *y);
+bool        ec_decompress(const MewCurve *c, const Mew *x, bool odd, MewPoint *p);
+MewPoint    ec_negate(const MewCurve *c, const MewPoint *p);
+MewPoint    ec_add(const MewCurve *c, const MewPoint *p, const MewPoint *q);
+MewPoint    ec_double(const MewCurve *c, const MewPoint *p);
+MewPoint    ec_mul(const MewCurve *c, const Mew *k, const MewPoint *p);
+MewEcTable *ec_table_build(const MewCurve *c, const MewPoint *p, int bits);
+void        ec_table_free(MewEcTable *t);
+MewPoint    ec_mul_table(const MewEcTable *t, const Mew *k);
+
+MewProgram *vm_compile(const char *src);
+void        vm_free(MewProgram *p);
+bool        vm_set(MewProgram *p, const char *name, const Mew *v);
+Mew         vm_run(MewProgram *p);
+
+MewPack *pack_new(void);
+void     pack_free(MewPack *p);
+bool     pack_append(MewPack *p, const Mew *a);
+bool     pack_append_bytes(MewPack *p, const uint8_t *bytes, size_t len);
+size_t   pack_load_bytes(MewPack *p, const uint8_t *buf, size_t len, size_t width);
+size_t   pack_count(const MewPack *p);
+size_t   pack_bytes(const MewPack *p);
+MewView  pack_get(const MewPack *p, size_t i);
+Mew      pack_load(const MewPack *p, size_t i);
+bool     pack_save(const MewPack *p, const char *path);
+MewPack *pack_map(const char *path);
+
+uint64_t  hash_mew(const Mew *a, uint64_t seed);
+uint64_t  hash_view(const MewView *v, uint64_t seed);
+MewTable *table_new(size_t expected, uint64_t seed);
+MewTable *table_new_fingerprint(size_t expected, uint64_t seed);
+void      table_free(MewTable *t);
+bool      table_put(MewTable *t, const Mew *key, uint64_t value);
+bool      table_get(const MewTable *t, const Mew *key, uint64_t *value);
+size_t    table_count(const MewTable *t);
+size_t    table_bytes(const MewTable *t);
+
+bool dlog_bsgs(const MewMod *m, const Mew *g, const Mew *h, uint64_t range,
+               size_t max_bytes, int threads, uint64_t *x);
+bool dlog_kangaroo(const MewMod *m, const Mew *g, const Mew *h, uint64_t range,
+                   uint64_t seed, uint64_t *x);
+
+int      pool_init(int threads);
+void     pool_shutdown(void);
+int      pool_threads(void);
+void     pool_run(MewTask *tasks, int n);
+
+MewRns     *rns_new(const Mew *n);
+void        rns_free(MewRns *c);
+int         rns_channels(const MewRns *c);
+MewRnsValue rns_from_mew(const MewRns *c, const Mew *a);
+Mew         rns_to_mew(const MewRns *c, const MewRnsValue *x);
+MewRnsValue rns_mul(const MewRns *c, const MewRnsValue *x, const MewRnsValue *y);
+Mew         rns_pow(const MewRns *c, const Mew *base, const Mew *exp);
+
+void     rng_seed(MewRng *rng, uint64_t seed, uint64_t stream);
+uint64_t rng_next(MewRng *rng);
+void     rng_fill(MewRng *rng, uint32_t *dst, int n);
+Mew      random_bits_r(MewRng *rng, int bits);
+Mew      random_below_r(MewRng *rng, const Mew *n);
+
+void     random_seed(uint64_t seed, uint64_t stream);
+Mew      random_bits(int bits);
+Mew      random_below(const Mew *n);
 
 #endif
@@ -2,6 +2,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 
@@ -20,14 +21,10 @@ Mew modm(const Mew *a, const Mew *mod) {
     Mew aa = abs_mew(a);
     Mew mm = abs_mew(mod);
 
-    Mew q = divm(&aa, &mm);
+    Mew rem;
+    Mew q = divmod(&aa, &mm, &rem);
     if (q.chozabretto) { r.chozabretto = true; return r; }
 
-    Mew prod = mul(&q, &mm);
-    Mew rem  = sub(&aa, &prod);
-
-    rem.negative = false;
-
     if (a->negative && !is_zero(&rem)) {
         rem = sub(&mm, &rem);
         rem.negative = false;
@@ -37,14 +34,26 @@ Mew modm(const Mew *a, const Mew *mod) {
 }
 
 
+static bool is_reduced(const Mew *a, const Mew *mm) {
+    return !a->negative && cmp(a, mm) < 0;
+}
+
+
 Mew mod_add(const Mew *a, const Mew *b, const Mew *mod) {
     Mew r = zero();
     if (!a || !b || !mod) { r.chozabretto = true; return r; }
     if (a->chozabretto || b->chozabretto || mod->chozabretto) { r.chozabretto = true; return r; }
     if (is_zero(mod)) { r.chozabretto = true; return r; }
 
+    Mew mm = abs_mew(mod);
     Mew sum = add(a, b);
     if (sum.chozabretto) { r.chozabretto = true; return r; }
+
+    /* reduced inputs: the sum is below 2 mod, one subtraction finishes it */
+    if (is_reduced(a, &mm) && is_reduced(b, &mm)) {
+        if (cmp(&sum, &mm) >= 0) sum = sub(&sum, &mm);
+        return sum;
+    }
     return modm(&sum, mod);
 }
 
@@ -55,19 +64,18 @@ Mew mod_subtract(const Mew *a, const Mew *b, const Mew *mod) {
     if (a->chozabretto || b->chozabretto || mod->chozabretto) { r.chozabretto = true; return r; }
     if (is_zero(mod)) { r.chozabretto = true; return r; }
 
-    Mew am = modm(a, mod);
-    Mew bm = modm(b, mod);
+    Mew mm = abs_mew(mod);
+    Mew am = is_reduced(a, &mm) ? copy(a) : modm(a, mod);
+    Mew bm = is_reduced(b, &mm) ? copy(b) : modm(b, mod);
     if (am.chozabretto || bm.chozabretto) { r.chozabretto = true; return r; }
 
     Mew diff = sub(&am, &bm);
-    Mew mm = abs_mew(mod);
-
     if (diff.negative) {
         diff = sub(&mm, &diff);
         diff.negative = false;
     }
 
-    return modm(&diff, &mm);
+    return diff;
 }
 
 
@@ -82,10 +90,7 @@ Mew barrett_mu(const Mew *mod) {
     int k = digit_len(&mm);
     if (k <= 0) { r.chozabretto = true; return r; }
 
-    Mew beta = from_u32(1);
-    beta = shift_digits_high(&beta, 2 * k);
-
-    Mew mu = divm(&beta, &mm);
+    Mew mu = reciprocal(&mm);
     if (mu.chozabretto || is_zero(&mu)) {
         mu.chozabretto = true;
         return mu;
@@ -125,6 +130,10 @@ Mew barrett_reduction(const Mew *x, const Mew *mod, const Mew *mu) {
         return modm(&xx, &mm);
     }
 
+    /* the estimate is at most a few moduli short; a division is only the last resort */
+    for (int i = 0; i < 4 && cmp(&R, &mm) >= 0; ++i)
+        R = sub(&R, &mm);
+
     if (cmp(&R, &mm) >= 0) {
         R = modm(&R, &mm);
     }
@@ -133,19 +142,639 @@ Mew barrett_reduction(const Mew *x, const Mew *mod, const Mew *mu) {
 }
 
 
+/*
+ * Modulus contexts. mu (or the special-form description) is computed once and
+ * shared by every reduction against the same modulus. Moduli 2^bits - c with
+ * a one-limb c, or with c a short signed sum of powers of two (Solinas form),
+ * are reduced by folding the high part back in: a few shifts, a multiply by a
+ * small constant and adds instead of two full Barrett products.
+ */
+
+#define SPECIAL_MIN_BITS 64
+#define SOLINAS_MIN_GAP  16
+
+#define FOLD_LEN (NUM_LEN + 4)
+
+static bool naf_terms(const Mew *c, MewMod *m) {
+    int bits = bit_len(c);
+    int carry = 0;
+    m->nterms = 0;
+    for (int i = 0; i <= bits; ++i) {
+        int t = (int)bit_at(c, i) + carry;
+        if (t == 1) {
+            if (m->nterms == SOLINAS_MAX_TERMS) return false;
+            int digit = bit_at(c, i + 1) ? -1 : 1;
+            m->term_shift[m->nterms] = i;
+            m->term_sign[m->nterms] = digit;
+            m->term_mult[m->nterms] = 1;
+            ++m->nterms;
+            carry = digit < 0;
+        } else {
+            carry = t == 2;
+        }
+    }
+    return true;
+}
+
+static void classify_special(MewMod *m, const Mew *c) {
+    m->form = MOD_GENERIC;
+    if (m->bits < SPECIAL_MIN_BITS || is_zero(c)) return;
+
+    if (digit_len(c) == 1) {
+        m->form = MOD_PSEUDO_MERSENNE;
+        m->nterms = 1;
+        m->term_shift[0] = 0;
+        m->term_sign[0] = 1;
+        m->term_mult[0] = c->numberArray[0];
+        return;
+    }
+
+    if (bit_len(c) > m->bits - SOLINAS_MIN_GAP) return;
+    if (naf_terms(c, m)) m->form = MOD_SOLINAS;
+}
+
+static bool lazy_bounds(MewMod *m) {
+    m->n2 = shift_left(&m->n, 1);
+    m->n4 = shift_left(&m->n, 2);
+    return m->bits + 3 <= NUM_LEN * 32;
+}
+
+static MewMod mod_context_error(void) {
+    MewMod m;
+    memset(&m, 0, sizeof(m));
+    m.chozabretto = true;
+    return m;
+}
+
+MewMod mod_context(const Mew *mod) {
+    if (!mod || mod->chozabretto || is_zero(mod)) return mod_context_error();
+
+    MewMod m;
+    memset(&m, 0, sizeof(m));
+    m.n = abs_mew(mod);
+    m.bits = bit_len(&m.n);
+    m.form = MOD_GENERIC;
+    if (!lazy_bounds(&m)) return mod_context_error();
+
+    if (m.bits < NUM_LEN * 32) {
+        Mew top = from_u32(1);
+        top = shift_left(&top, m.bits);
+        Mew c = sub(&top, &m.n);
+        classify_special(&m, &c);
+    }
+
+    if (m.form == MOD_GENERIC) {
+        m.mu = barrett_mu(&m.n);
+        if (m.mu.chozabretto) return mod_context_error();
+    }
+    return m;
+}
+
+MewMod mod_context_special(int bits, const Mew *c) {
+    if (!c || c->chozabretto || bits <= 0 || bits >= NUM_LEN * 32) return mod_context_error();
+
+    Mew top = from_u32(1);
+    top = shift_left(&top, bits);
+    if (cmp(c, &top) >= 0) return mod_context_error();
+
+    MewMod m;
+    memset(&m, 0, sizeof(m));
+    m.n = sub(&top, c);
+    m.bits = bits;
+    if (!lazy_bounds(&m)) return mod_context_error();
+    classify_special(&m, c);
+
+    if (m.form == MOD_GENERIC) {
+        m.mu = barrett_mu(&m.n);
+        if (m.mu.chozabretto) return mod_context_error();
+    }
+    return m;
+}
+
+static int words_len(const uint32_t *x, int n) {
+    while (n > 0 && !x[n - 1]) --n;
+    return n;
+}
+
+static int words_bits(const uint32_t *x, int n) {
+    n = words_len(x, n);
+    if (!n) return 0;
+    int b = 32;
+    while (!(x[n - 1] >> (b - 1))) --b;
+    return (n - 1) * 32 + b;
+}
+
+/* acc (cap limbs) += (h * mult) << shift */
+static void add_scaled(uint32_t *acc, int cap, const uint32_t *h, int hlen, uint32_t mult, int shift) {
+    int ws = shift / 32, bs = shift % 32;
+    uint64_t carry = 0, s = 0;
+    uint32_t prev = 0;
+    int i = 0;
+    for (; i <= hlen && ws + i < cap; ++i) {
+        uint64_t p = i < hlen ? (uint64_t)h[i] * mult + carry : carry;
+        carry = p >> 32;
+        uint32_t w = (uint32_t)p;
+        uint32_t shifted = bs ? (w << bs) | (prev >> (32 - bs)) : w;
+        prev = w;
+
+        s = (uint64_t)acc[ws + i] + shifted + (s >> 32);
+        acc[ws + i] = (uint32_t)s;
+    }
+    if (bs && ws + i < cap) {
+        s = (uint64_t)acc[ws + i] + (prev >> (32 - bs)) + (s >> 32);
+        acc[ws + i] = (uint32_t)s;
+        ++i;
+    }
+    for (; (s >> 32) && ws + i < cap; ++i) {
+        s = (uint64_t)acc[ws + i] + 1;
+        acc[ws + i] = (uint32_t)s;
+    }
+}
+
+/* a -= b over cap limbs, a >= b */
+static void sub_in_place(uint32_t *a, const uint32_t *b, int cap) {
+    uint32_t borrow = 0;
+    for (int i = 0; i < cap; ++i) {
+        uint64_t d = (uint64_t)a[i] - b[i] - borrow;
+        a[i] = (uint32_t)d;
+        borrow = (uint32_t)(d >> 63);
+    }
+}
+
+static int cmp_fold(const uint32_t *a, const uint32_t *b, int cap) {
+    for (int i = cap - 1; i >= 0; --i) {
+        if (a[i] > b[i]) return 1;
+        if (a[i] < b[i]) return -1;
+    }
+    return 0;
+}
+
+/* x mod (2^bits - c) for |x| < 2^(32 NUM_LEN), by folding x = H 2^bits + L into L + H c */
+static Mew reduce_special(const MewMod *m, const Mew *x) {
+    uint32_t t[FOLD_LEN], n[FOLD_LEN], h[FOLD_LEN], neg[FOLD_LEN];
+    int len = digit_len(x);
+    int nlen = digit_len(&m->n);
+    int cap = (len > nlen ? len : nlen) + 3;
+
+    memcpy(t, x->numberArray, (size_t)len * sizeof(uint32_t));
+    memset(t + len, 0, (size_t)(cap - len) * sizeof(uint32_t));
+    memcpy(n, m->n.numberArray, (size_t)nlen * sizeof(uint32_t));
+    memset(n + nlen, 0, (size_t)(cap - nlen) * sizeof(uint32_t));
+
+    int wb = m->bits / 32, sb = m->bits % 32;
+
+    while (words_bits(t, cap) > m->bits + 1) {
+        len = words_len(t, cap);
+
+        int hlen = len - wb;
+        for (int i = 0; i < hlen; ++i)
+            h[i] = (t[wb + i] >> sb) | (sb && wb + i + 1 < len ? t[wb + i + 1] << (32 - sb) : 0);
+        hlen = words_len(h, hlen);
+
+        for (int i = wb + 1; i < len; ++i) t[i] = 0;
+        t[wb] = sb ? t[wb] & ((1u << sb) - 1) : 0;
+
+        bool any_neg = false;
+        for (int j = 0; j < m->nterms; ++j) {
+            if (m->term_sign[j] > 0) {
+                add_scaled(t, cap, h, hlen, m->term_mult[j], m->term_shift[j]);
+            } else {
+                if (!any_neg) memset(neg, 0, (size_t)cap * sizeof(uint32_t));
+                add_scaled(neg, cap, h, hlen, m->term_mult[j], m->term_shift[j]);
+                any_neg = true;
+            }
+        }
+
+        if (any_neg) {
+            /* keep the fold non-negative: add n << j >= neg before subtracting */
+            int j = words_bits(neg, cap) - m->bits + 1;
+            if (j < 0) j = 0;
+            add_scaled(t, cap, n, nlen, 1, j);
+            sub_in_place(t, neg, cap);
+        }
+    }
+
+    while (cmp_fold(t, n, cap) >= 0)
+        sub_in_place(t, n, cap);
+
+    Mew r = zero();
+    memcpy(r.numberArray, t, (size_t)nlen * sizeof(uint32_t));
+    return r;
+}
+
+Mew mod_reduce(const MewMod *m, const Mew *x) {
+    Mew r = zero();
+    if (!m || !x || m->chozabretto || x->chozabretto) { r.chozabretto = true; return r; }
+
+    Mew xx = abs_mew(x);
+    if (m->form == MOD_GENERIC) r = barrett_reduction(&xx, &m->n, &m->mu);
+    else r = reduce_special(m, &xx);
+
+    if (x->negative && !is_zero(&r) && !r.chozabretto)
+        r = sub(&m->n, &r);
+    return r;
+}
+
+Mew mod_multiply_ctx(const MewMod *m, const Mew *a, const Mew *b) {
+    Mew r = zero();
+    if (!m || !a || !b || m->chozabretto || a->chozabretto || b->chozabretto) { r.chozabretto = true; return r; }
+
+    Mew prod = mul(a, b);
+    if (prod.chozabretto) { r.chozabretto = true; return r; }
+    return mod_reduce(m, &prod);
+}
+
+Mew mod_square_ctx(const MewMod *m, const Mew *a) {
+    return mod_multiply_ctx(m, a, a);
+}
+
+/* packed operands multiply straight from their limbs */
+Mew mod_multiply_view(const MewMod *m, const MewView *a, const MewView *b) {
+    Mew r = zero();
+    if (!m || !a || !b || m->chozabretto) { r.chozabretto = true; return r; }
+
+    Mew prod = mul_view(a, b);
+    if (prod.chozabretto) return prod;
+    return mod_reduce(m, &prod);
+}
+
+/*
+ * Additive operations against a context. The _ctx forms take reduced inputs
+ * and cost one add or sub plus a conditional correction; anything else falls
+ * back to a full reduction.
+ *
+ * The _lazy forms keep values in the redundant range [0, 4n) between
+ * multiplications, so chains of adds and subs need only one comparison each.
+ * mod_multiply_ctx accepts lazy operands and returns a fully reduced value;
+ * mod_normalize_lazy brings a lazy value back to [0, n).
+ */
+Mew mod_add_ctx(const MewMod *m, const Mew *a, const Mew *b) {
+    Mew r = zero();
+    if (!m || !a || !b || m->chozabretto || a->chozabretto || b->chozabretto) { r.chozabretto = true; return r; }
+
+    Mew sum = add(a, b);
+    if (is_reduced(a, &m->n) && is_reduced(b, &m->n)) {
+        if (cmp(&sum, &m->n) >= 0) sum = sub(&sum, &m->n);
+        return sum;
+    }
+    return mod_reduce(m, &sum);
+}
+
+Mew mod_subtract_ctx(const MewMod *m, const Mew *a, const Mew *b) {
+    Mew r = zero();
+    if (!m || !a || !b || m->chozabretto || a->chozabretto || b->chozabretto) { r.chozabretto = true; return r; }
+
+    Mew am = is_reduced(a, &m->n) ? copy(a) : mod_reduce(m, a);
+    Mew bm = is_reduced(b, &m->n) ? copy(b) : mod_reduce(m, b);
+
+    Mew diff = sub(&am, &bm);
+    if (diff.negative) {
+        diff = sub(&m->n, &diff);
+        diff.negative = false;
+    }
+    return diff;
+}
+
+Mew mod_add_lazy(const MewMod *m, const Mew *a, const Mew *b) {
+    Mew r = zero();
+    if (!m || !a || !b || m->chozabretto || a->chozabretto || b->chozabretto) { r.chozabretto = true; return r; }
+
+    Mew sum = add(a, b);
+    if (cmp(&sum, &m->n4) >= 0) sum = sub(&sum, &m->n4);
+    return sum;
+}
+
+Mew mod_subtract_lazy(const MewMod *m, const Mew *a, const Mew *b) {
+    Mew r = zero();
+    if (!m || !a || !b || m->chozabretto || a->chozabretto || b->chozabretto) { r.chozabretto = true; return r; }
+
+    Mew diff = add(a, &m->n4);
+    diff = sub(&diff, b);
+    if (cmp(&diff, &m->n4) >= 0) diff = sub(&diff, &m->n4);
+    return diff;
+}
+
+Mew mod_normalize_lazy(const MewMod *m, const Mew *a) {
+    Mew r = zero();
+    if (!m || !a || m->chozabretto || a->chozabretto) { r.chozabretto = true; return r; }
+
+    r = copy(a);
+    if (cmp(&r, &m->n2) >= 0) r = sub(&r, &m->n2);
+    if (cmp(&r, &m->n) >= 0) r = sub(&r, &m->n);
+    return r;
+}
+
+static int multi_pow_window(int nbits) {
+    if (nbits > 512) return 5;
+    if (nbits > 128) return 4;
+    if (nbits > 24)  return 3;
+    return 2;
+}
+
+/* sliding-window recoding: digits[i] holds the odd window value that ends at bit i, 0 elsewhere */
+static void recode_sliding(const Mew *exp, int w, uint8_t *digits) {
+    int i = bit_len(exp) - 1;
+    while (i >= 0) {
+        if (!bit_at(exp, i)) { --i; continue; }
+
+        int l = i - w + 1;
+        if (l < 0) l = 0;
+        while (!bit_at(exp, l)) ++l;
+
+        uint32_t d = 0;
+        for (int j = i; j >= l; --j)
+            d = (d << 1) | bit_at(exp, j);
+        digits[l] = (uint8_t)d;
+        i = l - 1;
+    }
+}
+
+/*
+ * Exponentiation by the shape of the exponent:
+ *
+ *   e = 65537          16 squarings and one multiply
+ *   e <= CHAIN_MAX_EXP shortest addition chain from ADDITION_CHAINS
+ *   otherwise          sliding windows over odd powers; the recoding of the
+ *                      last few exponents is cached per thread, so a fixed
+ *                      private or verification exponent is scanned only once
+ *
+ * Exponents wider than RECODE_MAX_BITS take the plain bit loop.
+ */
+
+#define CHAIN_MAX_EXP   255
+#define CHAIN_MAX_LEN   11
+#define RECODE_MAX_BITS 4096
+#define RECODE_MAX_STEPS (RECODE_MAX_BITS / 4)   /* at most nbits / w windows, w = 5 above 512 bits */
+#define RECODE_MAX_W    5
+#define RECODE_CACHE    4
+#define RECODE_SEED     0xBB67AE8584CAA73Bull
+
+/* ADDITION_CHAINS[e]: a shortest addition chain for e, after the leading 1 */
+static const uint8_t ADDITION_CHAINS[CHAIN_MAX_EXP + 1][CHAIN_MAX_LEN] = {
+    {0}, {0},
+    {2}, {2, 3},
+    {2, 4}, {2, 4, 5},
+    {2, 4, 6}, {2, 4, 6, 7},
+    {2, 4, 8}, {2, 4, 8, 9},
+    {2, 4, 8, 10}, {2, 4, 8, 10, 11},
+    {2, 4, 8, 12}, {2, 4, 8, 12, 13},
+    {2, 4, 8, 12, 14}, {2, 4, 5, 10, 15},
+    {2, 4, 8, 16}, {2, 4, 8, 16, 17},
+    {2, 4, 8, 16, 18}, {2, 4, 8, 16, 18, 19},
+    {2, 4, 8, 16, 20}, {2, 4, 8, 16, 20, 21},
+    {2, 4, 8, 16, 20, 22}, {2, 4, 5, 9, 18, 23},
+    {2, 4, 8, 16, 24}, {2, 4, 8, 16, 24, 25},
+    {2, 4, 8, 16, 24, 26}, {2, 4, 8, 9, 18, 27},
+    {2, 4, 8, 16, 24, 28}, {2, 4, 8, 16, 24, 28, 29},
+    {2, 4, 8, 10, 20, 30}, {2, 4, 8, 10, 20, 30, 31},
+    {2, 4, 8, 16, 32}, {2, 4, 8, 16, 32, 33},
+    {2, 4, 8, 16, 32, 34}, {2, 4, 8, 16, 32, 34, 35},
+    {2, 4, 8, 16, 32, 36}, {2, 4, 8, 16, 32, 36, 37},
+    {2, 4, 8, 16, 32, 36, 38}, {2, 4, 8, 12, 13, 26, 39},
+    {2, 4, 8, 16, 32, 40}, {2, 4, 8, 16, 32, 40, 41},
+    {2, 4, 8, 16, 32, 40, 42}, {2, 4, 8, 9, 17, 34, 43},
+    {2, 4, 8, 16, 32, 40, 44}, {2, 4, 8, 9, 18, 36, 45},
+    {2, 4, 8, 10, 18, 36, 46}, {2, 4, 8, 12, 13, 26, 39, 47},
+    {2, 4, 8, 16, 32, 48}, {2, 4, 8, 16, 32, 48, 49},
+    {2, 4, 8, 16, 32, 48, 50}, {2, 4, 8, 16, 17, 34, 51},
+    {2, 4, 8, 16, 32, 48, 52}, {2, 4, 8, 16, 32, 48, 52, 53},
+    {2, 4, 8, 16, 18, 36, 54}, {2, 4, 8, 16, 18, 36, 54, 55},
+    {2, 4, 8, 16, 32, 48, 56}, {2, 4, 8, 16, 32, 48, 56, 57},
+    {2, 4, 8, 16, 32, 48, 56, 58}, {2, 4, 8, 16, 17, 34, 51, 59},
+    {2, 4, 8, 16, 20, 40, 60}, {2, 4, 8, 16, 20, 40, 60, 61},
+    {2, 4, 8, 16, 20, 40, 60, 62}, {2, 4, 8, 16, 20, 21, 42, 63},
+    {2, 4, 8, 16, 32, 64}, {2, 4, 8, 16, 32, 64, 65},
+    {2, 4, 8, 16, 32, 64, 66}, {2, 4, 8, 16, 32, 64, 66, 67},
+    {2, 4, 8, 16, 32, 64, 68}, {2, 4, 8, 16, 32, 64, 68, 69},
+    {2, 4, 8, 16, 32, 64, 68, 70}, {2, 4, 8, 16, 32, 64, 68, 70, 71},
+    {2, 4, 8, 16, 32, 64, 72}, {2, 4, 8, 16, 32, 64, 72, 73},
+    {2, 4, 8, 16, 32, 64, 72, 74}, {2, 4, 8, 16, 24, 25, 50, 75},
+    {2, 4, 8, 16, 32, 64, 72, 76}, {2, 4, 8, 9, 17, 34, 68, 77},
+    {2, 4, 8, 16, 24, 26, 52, 78}, {2, 4, 8, 16, 24, 26, 52, 78, 79},
+    {2, 4, 8, 16, 32, 64, 80}, {2, 4, 8, 16, 32, 64, 80, 81},
+    {2, 4, 8, 16, 32, 64, 80, 82}, {2, 4, 8, 16, 17, 33, 66, 83},
+    {2, 4, 8, 16, 32, 64, 80, 84}, {2, 4, 8, 16, 17, 34, 68, 85},
+    {2, 4, 8, 16, 18, 34, 68, 86}, {2, 4, 8, 16, 24, 28, 29, 58, 87},
+    {2, 4, 8, 16, 32, 64, 80, 88}, {2, 4, 8, 16, 32, 64, 80, 88, 89},
+    {2, 4, 8, 16, 18, 36, 72, 90}, {2, 4, 8, 16, 24, 25, 50, 75, 91},
+    {2, 4, 8, 16, 20, 36, 72, 92}, {2, 4, 8, 16, 20, 36, 72, 92, 93},
+    {2, 4, 8, 16, 24, 26, 52, 78, 94}, {2, 4, 8, 16, 20, 21, 37, 74, 95},
+    {2, 4, 8, 16, 32, 64, 96}, {2, 4, 8, 16, 32, 64, 96, 97},
+    {2, 4, 8, 16, 32, 64, 96, 98}, {2, 4, 8, 16, 32, 33, 66, 99},
+    {2, 4, 8, 16, 32, 64, 96, 100}, {2, 4, 8, 16, 32, 64, 96, 100, 101},
+    {2, 4, 8, 16, 32, 34, 68, 102}, {2, 4, 8, 16, 32, 34, 68, 102, 103},
+    {2, 4, 8, 16, 32, 64, 96, 104}, {2, 4, 8, 16, 32, 64, 96, 104, 105},
+    {2, 4, 8, 16, 32, 64, 96, 104, 106}, {2, 4, 8, 16, 32, 33, 66, 99, 107},
+    {2, 4, 8, 16, 32, 36, 72, 108}, {2, 4, 8, 16, 32, 36, 72, 108, 109},
+    {2, 4, 8, 16, 32, 36, 72, 108, 110}, {2, 4, 8, 16, 32, 36, 37, 74, 111},
+    {2, 4, 8, 16, 32, 64, 96, 112}, {2, 4, 8, 16, 32, 64, 96, 112, 113},
+    {2, 4, 8, 16, 32, 64, 96, 112, 114}, {2, 4, 8, 16, 32, 33, 66, 99, 115},
+    {2, 4, 8, 16, 32, 64, 96, 112, 116}, {2, 4, 8, 16, 17, 34, 50, 100, 117},
+    {2, 4, 8, 16, 32, 34, 68, 102, 118}, {2, 4, 8, 16, 17, 34, 68, 102, 119},
+    {2, 4, 8, 16, 32, 40, 80, 120}, {2, 4, 8, 16, 32, 40, 80, 120, 121},
+    {2, 4, 8, 16, 32, 40, 80, 120, 122}, {2, 4, 8, 16, 32, 40, 41, 82, 123},
+    {2, 4, 8, 16, 32, 40, 80, 120, 124}, {2, 4, 8, 16, 24, 25, 50, 100, 125},
+    {2, 4, 8, 16, 32, 40, 42, 84, 126}, {2, 4, 8, 16, 32, 40, 42, 84, 126, 127},
+    {2, 4, 8, 16, 32, 64, 128}, {2, 4, 8, 16, 32, 64, 128, 129},
+    {2, 4, 8, 16, 32, 64, 128, 130}, {2, 4, 8, 16, 32, 64, 128, 130, 131},
+    {2, 4, 8, 16, 32, 64, 128, 132}, {2, 4, 8, 16, 32, 64, 128, 132, 133},
+    {2, 4, 8, 16, 32, 64, 128, 132, 134}, {2, 4, 8, 9, 18, 36, 45, 90, 135},
+    {2, 4, 8, 16, 32, 64, 128, 136}, {2, 4, 8, 16, 32, 64, 128, 136, 137},
+    {2, 4, 8, 16, 32, 64, 128, 136, 138}, {2, 4, 8, 16, 32, 64, 128, 136, 138, 139},
+    {2, 4, 8, 16, 32, 64, 128, 136, 140}, {2, 4, 8, 16, 32, 64, 128, 136, 140, 141},
+    {2, 4, 8, 16, 32, 64, 128, 136, 140, 142}, {2, 4, 8, 16, 32, 36, 37, 74, 111, 143},
+    {2, 4, 8, 16, 32, 64, 128, 144}, {2, 4, 8, 16, 32, 64, 128, 144, 145},
+    {2, 4, 8, 16, 32, 64, 128, 144, 146}, {2, 4, 8, 16, 32, 48, 49, 98, 147},
+    {2, 4, 8, 16, 32, 64, 128, 144, 148}, {2, 4, 8, 16, 17, 33, 66, 132, 149},
+    {2, 4, 8, 16, 32, 48, 50, 100, 150}, {2, 4, 8, 16, 32, 48, 50, 100, 150, 151},
+    {2, 4, 8, 16, 32, 64, 128, 144, 152}, {2, 4, 8, 16, 17, 34, 68, 136, 153},
+    {2, 4, 8, 16, 18, 34, 68, 136, 154}, {2, 4, 8, 16, 32, 48, 49, 98, 147, 155},
+    {2, 4, 8, 16, 32, 48, 52, 104, 156}, {2, 4, 8, 16, 32, 48, 52, 104, 156, 157},
+    {2, 4, 8, 16, 32, 48, 52, 104, 156, 158}, {2, 4, 8, 16, 32, 48, 52, 53, 106, 159},
+    {2, 4, 8, 16, 32, 64, 128, 160}, {2, 4, 8, 16, 32, 64, 128, 160, 161},
+    {2, 4, 8, 16, 32, 64, 128, 160, 162}, {2, 4, 8, 16, 32, 33, 65, 130, 163},
+    {2, 4, 8, 16, 32, 64, 128, 160, 164}, {2, 4, 8, 16, 32, 33, 66, 132, 165},
+    {2, 4, 8, 16, 32, 34, 66, 132, 166}, {2, 4, 8, 16, 32, 34, 66, 132, 166, 167},
+    {2, 4, 8, 16, 32, 64, 128, 160, 168}, {2, 4, 8, 16, 32, 64, 128, 160, 168, 169},
+    {2, 4, 8, 16, 32, 34, 68, 136, 170}, {2, 4, 8, 16, 32, 48, 56, 57, 114, 171},
+    {2, 4, 8, 16, 32, 36, 68, 136, 172}, {2, 4, 8, 16, 32, 36, 68, 136, 172, 173},
+    {2, 4, 8, 16, 32, 48, 56, 58, 116, 174}, {2, 4, 8, 16, 32, 36, 37, 69, 138, 175},
+    {2, 4, 8, 16, 32, 64, 128, 160, 176}, {2, 4, 8, 16, 32, 64, 128, 160, 176, 177},
+    {2, 4, 8, 16, 32, 64, 128, 160, 176, 178}, {2, 4, 8, 16, 32, 48, 49, 98, 147, 179},
+    {2, 4, 8, 16, 32, 36, 72, 144, 180}, {2, 4, 8, 16, 32, 36, 72, 144, 180, 181},
+    {2, 4, 8, 16, 32, 48, 50, 100, 150, 182}, {2, 4, 8, 16, 32, 36, 37, 73, 146, 183},
+    {2, 4, 8, 16, 32, 40, 72, 144, 184}, {2, 4, 8, 16, 32, 40, 72, 144, 184, 185},
+    {2, 4, 8, 16, 32, 40, 72, 144, 184, 186}, {2, 4, 8, 16, 32, 40, 41, 73, 146, 187},
+    {2, 4, 8, 16, 32, 48, 52, 104, 156, 188}, {2, 4, 8, 16, 32, 33, 41, 74, 148, 189},
+    {2, 4, 8, 16, 32, 40, 42, 74, 148, 190}, {2, 4, 8, 16, 32, 48, 52, 53, 106, 159, 191},
+    {2, 4, 8, 16, 32, 64, 128, 192}, {2, 4, 8, 16, 32, 64, 128, 192, 193},
+    {2, 4, 8, 16, 32, 64, 128, 192, 194}, {2, 4, 8, 16, 32, 64, 65, 130, 195},
+    {2, 4, 8, 16, 32, 64, 128, 192, 196}, {2, 4, 8, 16, 32, 64, 128, 192, 196, 197},
+    {2, 4, 8, 16, 32, 64, 66, 132, 198}, {2, 4, 8, 16, 32, 64, 66, 132, 198, 199},
+    {2, 4, 8, 16, 32, 64, 128, 192, 200}, {2, 4, 8, 16, 32, 64, 128, 192, 200, 201},
+    {2, 4, 8, 16, 32, 64, 128, 192, 200, 202}, {2, 4, 8, 16, 32, 64, 65, 130, 195, 203},
+    {2, 4, 8, 16, 32, 64, 68, 136, 204}, {2, 4, 8, 16, 32, 64, 68, 136, 204, 205},
+    {2, 4, 8, 16, 32, 64, 68, 136, 204, 206}, {2, 4, 8, 16, 32, 64, 68, 69, 138, 207},
+    {2, 4, 8, 16, 32, 64, 128, 192, 208}, {2, 4, 8, 16, 32, 64, 128, 192, 208, 209},
+    {2, 4, 8, 16, 32, 64, 128, 192, 208, 210}, {2, 4, 8, 16, 32, 64, 65, 130, 195, 211},
+    {2, 4, 8, 16, 32, 64, 128, 192, 208, 212}, {2, 4, 8, 16, 32, 33, 49, 82, 164, 213},
+    {2, 4, 8, 16, 32, 64, 66, 132, 198, 214}, {2, 4, 8, 16, 17, 33, 66, 132, 198, 215},
+    {2, 4, 8, 16, 32, 64, 72, 144, 216}, {2, 4, 8, 16, 32, 64, 72, 144, 216, 217},
+    {2, 4, 8, 16, 32, 64, 72, 144, 216, 218}, {2, 4, 8, 16, 32, 64, 72, 73, 146, 219},
+    {2, 4, 8, 16, 32, 64, 72, 144, 216, 220}, {2, 4, 8, 16, 24, 25, 49, 98, 196, 221},
+    {2, 4, 8, 16, 32, 64, 72, 74, 148, 222}, {2, 4, 8, 16, 32, 64, 72, 74, 148, 222, 223},
+    {2, 4, 8, 16, 32, 64, 128, 192, 224}, {2, 4, 8, 16, 32, 64, 128, 192, 224, 225},
+    {2, 4, 8, 16, 32, 64, 128, 192, 224, 226}, {2, 4, 8, 16, 32, 64, 65, 130, 195, 227},
+    {2, 4, 8, 16, 32, 64, 128, 192, 224, 228}, {2, 4, 8, 16, 32, 33, 66, 98, 196, 229},
+    {2, 4, 8, 16, 32, 64, 66, 132, 198, 230}, {2, 4, 8, 16, 32, 33, 66, 132, 198, 231},
+    {2, 4, 8, 16, 32, 64, 128, 192, 224, 232}, {2, 4, 8, 16, 17, 33, 50, 100, 200, 233},
+    {2, 4, 8, 16, 32, 34, 68, 100, 200, 234}, {2, 4, 8, 16, 32, 64, 72, 73, 146, 219, 235},
+    {2, 4, 8, 16, 32, 64, 68, 136, 204, 236}, {2, 4, 8, 16, 32, 64, 68, 136, 204, 236, 237},
+    {2, 4, 8, 16, 32, 34, 68, 136, 204, 238}, {2, 4, 8, 16, 32, 64, 68, 69, 138, 207, 239},
+    {2, 4, 8, 16, 32, 64, 80, 160, 240}, {2, 4, 8, 16, 32, 64, 80, 160, 240, 241},
+    {2, 4, 8, 16, 32, 64, 80, 160, 240, 242}, {2, 4, 8, 16, 32, 64, 80, 81, 162, 243},
+    {2, 4, 8, 16, 32, 64, 80, 160, 240, 244}, {2, 4, 8, 16, 32, 48, 49, 98, 196, 245},
+    {2, 4, 8, 16, 32, 64, 80, 82, 164, 246}, {2, 4, 8, 16, 32, 64, 80, 82, 164, 246, 247},
+    {2, 4, 8, 16, 32, 64, 80, 160, 240, 248}, {2, 4, 8, 16, 17, 33, 66, 83, 166, 249},
+    {2, 4, 8, 16, 32, 48, 50, 100, 200, 250}, {2, 4, 8, 16, 32, 64, 80, 81, 162, 243, 251},
+    {2, 4, 8, 16, 32, 64, 80, 84, 168, 252}, {2, 4, 8, 16, 32, 64, 80, 84, 168, 252, 253},
+    {2, 4, 8, 16, 32, 64, 80, 84, 168, 252, 254}, {2, 4, 8, 16, 17, 34, 68, 85, 170, 255},
+};
+
+typedef struct {
+    uint64_t hash;
+    int nlimbs;
+    uint32_t limbs[RECODE_MAX_BITS / 32];
+    int w;
+    int nsteps;
+    uint16_t pos[RECODE_MAX_STEPS];       /* window ends, high to low */
+    uint8_t digit[RECODE_MAX_STEPS];      /* odd window values */
+} Recoding;
+
+static _Thread_local Recoding recode_cache[RECODE_CACHE];
+static _Thread_local int recode_used;
+static _Thread_local int recode_next;
+
+static Mew pow_65537(const MewMod *m, const Mew *b) {
+    Mew r = copy(b);
+    for (int i = 0; i < 16; ++i)
+        r = mod_square_ctx(m, &r);
+    return mod_multiply_ctx(m, &r, b);
+}
+
+static Mew pow_chain(const MewMod *m, const Mew *b, uint32_t e) {
+    Mew pw[CHAIN_MAX_LEN + 1];
+    uint32_t val[CHAIN_MAX_LEN + 1];
+    pw[0] = copy(b);
+    val[0] = 1;
+
+    int n = 1;
+    for (const uint8_t *c = ADDITION_CHAINS[e]; val[n - 1] != e; ++c, ++n) {
+        /* prefer the newest terms; the table guarantees a pair exists */
+        int i = n - 1, j = n - 1;
+        while (val[i] + val[j] != *c) {
+            if (j > 0) --j;
+            else j = --i;
+        }
+        pw[n] = i == j ? mod_square_ctx(m, &pw[i]) : mod_multiply_ctx(m, &pw[i], &pw[j]);
+        val[n] = *c;
+        if (pw[n].chozabretto) return pw[n];
+    }
+    return pw[n - 1];
+}
+
+static const Recoding *recoding(const Mew *exp, int nbits) {
+    int nlimbs = digit_len(exp);
+    uint64_t h = hash_mew(exp, RECODE_SEED);
+    for (int k = 0; k < recode_used; ++k) {
+        Recoding *rc = &recode_cache[k];
+        if (rc->hash == h && rc->nlimbs == nlimbs
+            && !memcmp(rc->limbs, exp->numberArray, (size_t)nlimbs * sizeof(uint32_t)))
+            return rc;
+    }
+
+    Recoding *rc = &recode_cache[recode_next];
+    recode_next = (recode_next + 1) % RECODE_CACHE;
+    if (recode_used < RECODE_CACHE) ++recode_used;
+
+    uint8_t digits[RECODE_MAX_BITS] = {0};
+    rc->w = multi_pow_window(nbits);
+    recode_sliding(exp, rc->w, digits);
+    rc->nsteps = 0;
+    for (int i = nbits - 1; i >= 0; --i) {
+        if (!digits[i]) continue;
+        rc->pos[rc->nsteps] = (uint16_t)i;
+        rc->digit[rc->nsteps] = digits[i];
+        ++rc->nsteps;
+    }
+    rc->hash = h;
+    rc->nlimbs = nlimbs;
+    memcpy(rc->limbs, exp->numberArray, (size_t)nlimbs * sizeof(uint32_t));
+    return rc;
+}
+
+static Mew pow_window(const MewMod *m, const Mew *b, const Recoding *rc) {
+    Mew table[1 << (RECODE_MAX_W - 1)];
+    int tsize = 1 << (rc->w - 1);
+    table[0] = copy(b);
+    Mew b2 = mod_square_ctx(m, b);
+    for (int i = 1; i < tsize; ++i)
+        table[i] = mod_multiply_ctx(m, &table[i - 1], &b2);
+
+    Mew r = copy(&table[rc->digit[0] >> 1]);
+    for (int k = 1; k < rc->nsteps; ++k) {
+        for (int s = rc->pos[k - 1] - rc->pos[k]; s > 0; --s)
+            r = mod_square_ctx(m, &r);
+        r = mod_multiply_ctx(m, &r, &table[rc->digit[k] >> 1]);
+        if (r.chozabretto) return r;
+    }
+    for (int s = rc->pos[rc->nsteps - 1]; s > 0; --s)
+        r = mod_square_ctx(m, &r);
+    return r;
+}
+
+Mew mod_pow_ctx(const MewMod *m, const Mew *base, const Mew *exp) {
+    Mew r = zero();
+    if (!m || !base || !exp || m->chozabretto || base->chozabretto || exp->chozabretto) {
+        r.chozabretto = true;
+        return r;
+    }
+
+    Mew b = mod_reduce(m, base);
+    Mew result = from_u32(1);
+
+    int nbits = bit_len(exp);
+    if (nbits == 0) return mod_reduce(m, &result);
+    if (nbits <= 17) {
+        uint32_t e = exp->numberArray[0];
+        if (e == 65537) return pow_65537(m, &b);
+        if (e <= CHAIN_MAX_EXP) return pow_chain(m, &b, e);
+    }
+    if (nbits <= RECODE_MAX_BITS) return pow_window(m, &b, recoding(exp, nbits));
+
+    for (int i = nbits - 1; i >= 0; --i) {
+        result = mod_square_ctx(m, &result);
+        if (result.chozabretto) return result;
+
+        if (bit_at(exp, i)) {
+            result = mod_multiply_ctx(m, &result, &b);
+            if (result.chozabretto) return result;
+        }
+    }
+
+    return result;
+}
+
 Mew mod_multiply(const Mew *a, const Mew *b, const Mew *mod) {
     Mew r = zero();
     if (!a || !b || !mod) { r.chozabretto = true; return r; }
     if (a->chozabretto || b->chozabretto || mod->chozabretto) { r.chozabretto = true; return r; }
     if (is_zero(mod)) { r.chozabretto = true; return r; }
 
-    Mew mu = barrett_mu(mod);
-    if (mu.chozabretto) { r.chozabretto = true; return r; }
-
-    Mew prod = mul(a, b);
-    if (prod.chozabretto) { r.chozabretto = true; return r; }
+    MewMod m = mod_context(mod);
+    if (m.chozabretto) { r.chozabretto = true; return r; }
 
-    return barrett_reduction(&prod, mod, &mu);
+    return mod_multiply_ctx(&m, a, b);
 }
 
 
@@ -160,26 +789,88 @@ Mew mod_pow_barrett(const Mew *base, const Mew *exp, const Mew *mod) {
     if (base->chozabretto || exp->chozabretto || mod->chozabretto) { r.chozabretto = true; return r; }
     if (is_zero(mod)) { r.chozabretto = true; return r; }
 
-    Mew mu = barrett_mu(mod);
-    if (mu.chozabretto) { r.chozabretto = true; return r; }
+    /* callers verifying under one key repeat the modulus: keep its context */
+    static _Thread_local MewMod last;
+    static _Thread_local bool have_last;
+    if (!have_last || cmp(&last.n, mod) != 0) {
+        last = mod_context(mod);
+        have_last = !last.chozabretto;
+        if (!have_last) { r.chozabretto = true; return r; }
+    }
 
-    Mew b = barrett_reduction(base, mod, &mu);
+    return mod_pow_ctx(&last, base, exp);
+}
 
-    Mew result = from_u32(1);
 
-    int nbits = bit_len(exp);
-    for (int i = nbits - 1; i >= 0; --i) {
-        result = mul(&result, &result);
-        if (result.chozabretto) { r.chozabretto = true; return r; }
-        result = barrett_reduction(&result, mod, &mu);
+/*
+ * prod bases[j]^exps[j] mod mod (Straus / Shamir's trick).
+ * All k exponents share one squaring chain; each base contributes a multiply
+ * from its own table of odd powers whenever one of its windows ends.
+ */
+Mew mod_multi_pow(const Mew *bases, const Mew *exps, int k, const Mew *mod) {
+    Mew r = zero();
+    if (!bases || !exps || !mod || k <= 0) { r.chozabretto = true; return r; }
+    if (mod->chozabretto || is_zero(mod)) { r.chozabretto = true; return r; }
+    for (int j = 0; j < k; ++j)
+        if (bases[j].chozabretto || exps[j].chozabretto) { r.chozabretto = true; return r; }
+
+    MewMod m = mod_context(mod);
+    if (m.chozabretto) { r.chozabretto = true; return r; }
+
+    int nbits = 0;
+    for (int j = 0; j < k; ++j) {
+        int b = bit_len(&exps[j]);
+        if (b > nbits) nbits = b;
+    }
 
-        if (bit_at(exp, i)) {
-            result = mul(&result, &b);
-            if (result.chozabretto) { r.chozabretto = true; return r; }
-            result = barrett_reduction(&result, mod, &mu);
+    Mew one = from_u32(1);
+    if (nbits == 0) return mod_reduce(&m, &one);
+
+    int w = multi_pow_window(nbits);
+    int tsize = 1 << (w - 1);
+
+    Mew *table = malloc((size_t)k * tsize * sizeof(Mew));
+    uint8_t *digits = calloc((size_t)k * nbits, 1);
+    if (!table || !digits) {
+        free(table);
+        free(digits);
+        r.chozabretto = true;
+        return r;
+    }
+
+    for (int j = 0; j < k; ++j) {
+        Mew *t = table + (size_t)j * tsize;
+        t[0] = mod_reduce(&m, &bases[j]);
+        Mew b2 = mod_square_ctx(&m, &t[0]);
+        for (int i = 1; i < tsize; ++i)
+            t[i] = mod_multiply_ctx(&m, &t[i - 1], &b2);
+        recode_sliding(&exps[j], w, digits + (size_t)j * nbits);
+    }
+
+    Mew result = one;
+    bool started = false;
+    for (int i = nbits - 1; i >= 0; --i) {
+        if (started) result = mod_square_ctx(&m, &result);
+
+        for (int j = 0; j < k; ++j) {
+            uint8_t d = digits[(size_t)j * nbits + i];
+            if (!d) continue;
+
+            const Mew *t = &table[(size_t)j * tsize + (d >> 1)];
+            if (started) {
+                result = mod_multiply_ctx(&m, &result, t);
+            } else {
+                result = copy(t);
+                started = true;
+            }
         }
+        if (result.chozabretto) break;
     }
 
+    free(table);
+    free(digits);
+
+    if (!started) return mod_reduce(&m, &one);
     return result;
 }
 
@@ -226,29 +917,6 @@ Mew lcm(const Mew *a, const Mew *b) {
 
 
 
-static Mew random_below(const Mew *n) {
-    Mew r = zero();
-    int bits = bit_len(n);
-
-    do {
-        for (int i = 0; i < NUM_LEN; ++i)
-            r.numberArray[i] =
-                ((uint32_t)rand() << 16) ^ (uint32_t)rand();
-
-        int excess = NUM_LEN * 32 - bits;
-        if (excess > 0) {
-            uint32_t mask = (bits % 32 == 0)
-                ? 0xFFFFFFFFu
-                : ((1u << (bits % 32)) - 1);
-            r.numberArray[bits / 32] &= mask;
-            for (int i = bits / 32 + 1; i < NUM_LEN; ++i)
-                r.numberArray[i] = 0;
-        }
-    } while (cmp(&r, n) >= 0 || is_zero(&r));
-
-    return r;
-}
-
 static Mew random_base(const Mew *n) {
     Mew three = from_u32(3);
     Mew nm3 = sub(n, &three);
@@ -257,10 +925,115 @@ static Mew random_base(const Mew *n) {
     return add(&r, &two);
 }
 
+/*
+ * Extended Euclid on magnitudes: the Bezout coefficients alternate in sign,
+ * so |t[i+1]| = |t[i-1]| + q |t[i]| and the sign is fixed by the step count.
+ */
+Mew mod_inverse(const Mew *a, const Mew *mod) {
+    Mew err = zero();
+    err.chozabretto = true;
+    if (!a || !mod || a->chozabretto || mod->chozabretto || is_zero(mod)) return err;
+
+    Mew one = from_u32(1);
+    Mew n = abs_mew(mod);
+    if (cmp(&n, &one) == 0) return zero();
+
+    Mew r0 = n;
+    Mew r1 = modm(a, mod);
+    Mew t0 = zero();
+    Mew t1 = from_u32(1);
+    bool t1_negative = false;
+
+    while (!is_zero(&r1) && cmp(&r1, &one) != 0) {
+        Mew r2;
+        Mew q = divmod(&r0, &r1, &r2);
+        if (q.chozabretto) return err;
+
+        Mew qt = mul(&q, &t1);
+        Mew t2 = add(&t0, &qt);
+        r0 = r1;
+        r1 = r2;
+        t0 = t1;
+        t1 = t2;
+        t1_negative = !t1_negative;
+    }
+    if (is_zero(&r1)) return err;
+
+    return t1_negative ? sub(&n, &t1) : t1;
+}
+
+Mew mod_inverse_ctx(const MewMod *m, const Mew *a) {
+    Mew err = zero();
+    err.chozabretto = true;
+    if (!m || m->chozabretto) return err;
+    return mod_inverse(a, &m->n);
+}
+
+/*
+ * Montgomery's trick: scratch[i] holds a[0] ... a[i], one inversion of the full
+ * product, then each inverse is peeled off walking back, 3(k - 1)
+ * multiplications in all. scratch needs room for k values; out may alias in.
+ * Returns -1 when every element was inverted, otherwise the index of the first
+ * element sharing a factor with the modulus, and out is left unspecified.
+ * Returns -2 for bad arguments (NULL, an errored context, k <= 0) or when the
+ * product could not be inverted although no element shares a factor.
+ */
+int mod_batch_inverse(const MewMod *m, const Mew *in, Mew *out, Mew *scratch, int k) {
+    if (!m || m->chozabretto || !in || !out || !scratch || k <= 0) return -2;
+
+    scratch[0] = mod_reduce(m, &in[0]);
+    for (int i = 1; i < k; ++i)
+        scratch[i] = mod_multiply_ctx(m, &scratch[i - 1], &in[i]);
+
+    Mew inv = mod_inverse_ctx(m, &scratch[k - 1]);
+    if (inv.chozabretto) {
+        Mew one = from_u32(1);
+        for (int i = 0; i < k; ++i) {
+            Mew g = gcd(&in[i], &m->n);
+            if (cmp(&g, &one) != 0) return i;
+        }
+        return -2;
+    }
+
+    for (int i = k - 1; i > 0; --i) {
+        Mew ai = in[i];
+        out[i] = mod_multiply_ctx(m, &inv, &scratch[i - 1]);
+        inv = mod_multiply_ctx(m, &inv, &ai);
+    }
+    out[0] = inv;
+    return -1;
+}
+
+/* one strong-probable-prime round to base a, with n - 1 = d 2^s */
+static bool strong_probable_prime(const MewMod *m, const Mew *n_minus_1, const Mew *d, int s, const Mew *a) {
+    Mew one = from_u32(1);
+
+    Mew x = mod_pow_ctx(m, a, d);
+    if (x.chozabretto) return false;
+
+    if (cmp(&x, &one) == 0 || cmp(&x, n_minus_1) == 0)
+        return true;
+
+    for (int r = 1; r < s; ++r) {
+        x = mod_square_ctx(m, &x);
+        if (x.chozabretto) return false;
+
+        if (cmp(&x, n_minus_1) == 0)
+            return true;
+    }
+    return false;
+}
+
+static int split_twos(const Mew *n, Mew *d) {
+    int s = 0;
+    while (!bit_at(n, s) && s < NUM_LEN * 32) ++s;
+    *d = shift_right(n, s);
+    return s;
+}
+
 bool miller_rabin(const Mew *n, int rounds) {
     if (!n || n->chozabretto) return false;
 
-    Mew zero_m = zero();
     Mew one  = from_u32(1);
     Mew two  = from_u32(2);
     Mew four = from_u32(4);
@@ -270,36 +1043,307 @@ bool miller_rabin(const Mew *n, int rounds) {
     if (is_even(n)) return false;
 
     Mew n_minus_1 = sub(n, &one);
-    Mew d = copy(&n_minus_1);
-    int s = 0;
+    Mew d;
+    int s = split_twos(&n_minus_1, &d);
 
-    while (is_even(&d)) {
-        d = shift_right(&d, 1);
-        s++;
-    }
+    MewMod m = mod_context(n);
+    if (m.chozabretto) return false;
 
     for (int i = 0; i < rounds; ++i) {
         Mew a = random_base(n);
+        if (!strong_probable_prime(&m, &n_minus_1, &d, s, &a)) return false;
+    }
 
-        Mew x = mod_pow_barrett(&a, &d, n);
-        if (x.chozabretto) return false;
+    return true;
+}
+
+
+/* Jacobi symbol (a/n) for odd n > 0; 0 when n is even or zero */
+int jacobi(const Mew *a, const Mew *n) {
+    if (!a || !n || a->chozabretto || n->chozabretto) return 0;
+    if (is_zero(n) || is_even(n)) return 0;
+
+    Mew x = modm(a, n);
+    Mew y = abs_mew(n);
+    int t = 1;
+
+    while (!is_zero(&x)) {
+        int tz = 0;
+        while (!bit_at(&x, tz)) ++tz;
+        if (tz) {
+            x = shift_right(&x, tz);
+            uint32_t r8 = y.numberArray[0] & 7;
+            if ((tz & 1) && (r8 == 3 || r8 == 5)) t = -t;
+        }
+
+        Mew tmp = x;
+        x = y;
+        y = tmp;
+        if ((x.numberArray[0] & 3) == 3 && (y.numberArray[0] & 3) == 3) t = -t;
+
+        x = modm(&x, &y);
+    }
+
+    Mew one = from_u32(1);
+    return cmp(&y, &one) == 0 ? t : 0;
+}
 
-        if (cmp(&x, &one) == 0 || cmp(&x, &n_minus_1) == 0)
-            continue;
+static Mew half_mod(const MewMod *m, const Mew *x) {
+    if (is_even(x)) return shift_right(x, 1);
+    Mew t = add(x, &m->n);
+    return shift_right(&t, 1);
+}
 
-        bool composite = true;
-        for (int r = 1; r < s; ++r) {
-            x = mod_square(&x, n);
-            if (x.chozabretto) return false;
+/*
+ * Strong Lucas probable-prime test with Selfridge's parameters: D is the first
+ * of 5, -7, 9, -11, ... with (D/n) = -1, P = 1, Q = (1 - D) / 4.
+ */
+bool lucas_strong(const Mew *n) {
+    if (!n || n->chozabretto) return false;
 
-            if (cmp(&x, &n_minus_1) == 0) {
-                composite = false;
-                break;
+    Mew two = from_u32(2);
+    if (cmp(n, &two) < 0) return false;
+    if (cmp(n, &two) == 0) return true;
+    if (is_even(n) || is_square(n)) return false;
+
+    MewMod m = mod_context(n);
+    if (m.chozabretto) return false;
+
+    /* D = sign * dabs */
+    uint32_t dabs = 5;
+    bool dneg = false;
+    for (;;) {
+        Mew dm = from_u32(dabs);
+        dm.negative = dneg;
+        int j = jacobi(&dm, n);
+        if (j == -1) break;
+        if (j == 0) {
+            Mew dd = from_u32(dabs);
+            return cmp(n, &dd) == 0;
+        }
+        dabs += 2;
+        dneg = !dneg;
+        if (dabs > 0x7FFFFFFFu) return false;
+    }
+
+    /* Q = (1 - D) / 4 */
+    Mew q;
+    if (dneg) {
+        q = from_u32((dabs + 1) / 4);
+    } else {
+        Mew qa = from_u32((dabs - 1) / 4);
+        q = sub(&m.n, &qa);
+    }
+    q = mod_reduce(&m, &q);
+
+    Mew d_mod = from_u32(dabs);
+    d_mod = mod_reduce(&m, &d_mod);
+    if (dneg && !is_zero(&d_mod)) d_mod = sub(&m.n, &d_mod);
+
+    Mew one = from_u32(1);
+    Mew n_plus_1 = add(n, &one);
+    Mew d;
+    int s = split_twos(&n_plus_1, &d);
+
+    Mew u = from_u32(1);
+    Mew v = from_u32(1);
+    Mew qk = copy(&q);
+
+    for (int i = bit_len(&d) - 2; i >= 0; --i) {
+        u = mod_multiply_ctx(&m, &u, &v);
+        v = mod_square_ctx(&m, &v);
+        Mew q2 = mod_add_ctx(&m, &qk, &qk);
+        v = mod_subtract_ctx(&m, &v, &q2);
+        qk = mod_square_ctx(&m, &qk);
+
+        if (bit_at(&d, i)) {
+            Mew uv = mod_add_ctx(&m, &u, &v);
+            Mew du = mod_multiply_ctx(&m, &d_mod, &u);
+            Mew duv = mod_add_ctx(&m, &du, &v);
+            u = half_mod(&m, &uv);
+            v = half_mod(&m, &duv);
+            qk = mod_multiply_ctx(&m, &qk, &q);
+        }
+        if (u.chozabretto || v.chozabretto || qk.chozabretto) return false;
+    }
+
+    if (is_zero(&u) || is_zero(&v)) return true;
+
+    for (int r = 1; r < s; ++r) {
+        v = mod_square_ctx(&m, &v);
+        Mew q2 = mod_add_ctx(&m, &qk, &qk);
+        v = mod_subtract_ctx(&m, &v, &q2);
+        if (is_zero(&v)) return true;
+        qk = mod_square_ctx(&m, &qk);
+    }
+    return false;
+}
+
+static const uint32_t SMALL_PRIMES[] = {
+    3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71,
+    73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131, 137, 139, 149, 151
+};
+
+/*
+ * Baillie-PSW: trial division, one base-2 strong probable-prime test and one
+ * strong Lucas test. Deterministic, with no known counterexample.
+ */
+bool baillie_psw(const Mew *n) {
+    if (!n || n->chozabretto) return false;
+
+    Mew two = from_u32(2);
+    if (cmp(n, &two) < 0) return false;
+    if (cmp(n, &two) == 0) return true;
+    if (is_even(n)) return false;
+
+    for (size_t i = 0; i < sizeof(SMALL_PRIMES) / sizeof(SMALL_PRIMES[0]); ++i) {
+        Mew p = from_u32(SMALL_PRIMES[i]);
+        if (cmp(n, &p) == 0) return true;
+        Mew r = modm(n, &p);
+        if (is_zero(&r)) return false;
+    }
+
+    Mew one = from_u32(1);
+    Mew n_minus_1 = sub(n, &one);
+    Mew d;
+    int s = split_twos(&n_minus_1, &d);
+
+    MewMod m = mod_context(n);
+    if (m.chozabretto) return false;
+    if (!strong_probable_prime(&m, &n_minus_1, &d, s, &two)) return false;
+
+    return lucas_strong(n);
+}
+
+
+/*
+ * Square roots modulo an odd prime. The context fixes the method once:
+ *
+ *   p = 3 mod 4   r = a^((p+1)/4)
+ *   p = 5 mod 8   Atkin: b = (2a)^((p-5)/8), i = 2ab^2, r = ab(i - 1)
+ *   otherwise     Tonelli-Shanks with p - 1 = q 2^s and z = n^q for a
+ *                 non-residue n found once
+ *
+ * Every path ends by squaring the candidate (or, for Tonelli-Shanks, by
+ * running out of 2-power order), so a non-residue is reported without a
+ * separate Euler-criterion exponentiation.
+ */
+MewSqrt sqrt_context(const MewMod *m) {
+    MewSqrt c;
+    memset(&c, 0, sizeof(c));
+    if (!m || m->chozabretto || is_even(&m->n)) {
+        c.chozabretto = true;
+        return c;
+    }
+
+    c.m = *m;
+    Mew one = from_u32(1);
+    uint32_t low = m->n.numberArray[0];
+
+    if ((low & 3) == 3) {
+        c.kind = SQRT_3MOD4;
+        Mew t = add(&m->n, &one);
+        c.exp = shift_right(&t, 2);
+    } else if ((low & 7) == 5) {
+        c.kind = SQRT_5MOD8;
+        c.exp = shift_right(&m->n, 3);
+    } else {
+        c.kind = SQRT_TONELLI;
+        Mew pm1 = sub(&m->n, &one);
+        Mew q;
+        c.s = split_twos(&pm1, &q);
+        Mew qm1 = sub(&q, &one);
+        c.exp = shift_right(&qm1, 1);
+
+        uint32_t z = 2;
+        for (;; ++z) {
+            Mew zm = from_u32(z);
+            int j = jacobi(&zm, &m->n);
+            if (j == -1) break;
+            if (j == 0 || z == 0xFFFFFFFFu) {
+                c.chozabretto = true;
+                return c;
             }
         }
+        Mew zm = from_u32(z);
+        c.z = mod_pow_ctx(m, &zm, &q);
+    }
+    return c;
+}
 
-        if (composite) return false;
+static bool sqrt_tonelli(const MewSqrt *c, const Mew *a, Mew *root) {
+    const MewMod *m = &c->m;
+    Mew one = from_u32(1);
+
+    /* w = a^((q-1)/2): t = a^q, r = a^((q+1)/2) */
+    Mew w = mod_pow_ctx(m, a, &c->exp);
+    Mew r = mod_multiply_ctx(m, a, &w);
+    Mew t = mod_multiply_ctx(m, &r, &w);
+    Mew z = c->z;
+    int order = c->s;
+
+    while (cmp(&t, &one) != 0) {
+        int i = 0;
+        Mew t2 = t;
+        while (cmp(&t2, &one) != 0) {
+            t2 = mod_square_ctx(m, &t2);
+            if (++i == order) return false;
+        }
+
+        Mew b = z;
+        for (int j = 0; j < order - i - 1; ++j) b = mod_square_ctx(m, &b);
+        order = i;
+        z = mod_square_ctx(m, &b);
+        t = mod_multiply_ctx(m, &t, &z);
+        r = mod_multiply_ctx(m, &r, &b);
+    }
+    *root = r;
+    return true;
+}
+
+bool mod_sqrt_ctx(const MewSqrt *c, const Mew *a, Mew *root) {
+    if (!c || !a || !root || c->chozabretto || a->chozabretto) return false;
+
+    const MewMod *m = &c->m;
+    Mew x = mod_reduce(m, a);
+    if (is_zero(&x)) {
+        *root = x;
+        return true;
+    }
+
+    Mew r;
+    if (c->kind == SQRT_3MOD4) {
+        r = mod_pow_ctx(m, &x, &c->exp);
+    } else if (c->kind == SQRT_5MOD8) {
+        Mew x2 = mod_add_ctx(m, &x, &x);
+        Mew b = mod_pow_ctx(m, &x2, &c->exp);
+        Mew i = mod_square_ctx(m, &b);
+        i = mod_multiply_ctx(m, &i, &x2);
+        Mew one = from_u32(1);
+        Mew im1 = mod_subtract_ctx(m, &i, &one);
+        r = mod_multiply_ctx(m, &x, &b);
+        r = mod_multiply_ctx(m, &r, &im1);
+    } else {
+        return sqrt_tonelli(c, &x, root);
     }
 
+    Mew check = mod_square_ctx(m, &r);
+    if (cmp(&check, &x) != 0) return false;
+    *root = r;
     return true;
 }
+
+Mew mod_sqrt(const Mew *a, const Mew *p) {
+    Mew err = zero();
+    err.chozabretto = true;
+    if (!p || p->chozabretto) return err;
+
+    Mew two = from_u32(2);
+    if (cmp(p, &two) == 0) return modm(a, p);
+
+    MewMod m = mod_context(p);
+    MewSqrt c = sqrt_context(&m);
+    Mew r;
+    if (!mod_sqrt_ctx(&c, a, &r)) return err;
+    return r;
+}
@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "mew.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Packed number tables. Values are stored as their significant limbs only,
+ * back to back in one buffer; off[i] .. off[i + 1] is the run of element i.
+ * The sign of element i rides in the top bit of off[i + 1]. A 256-bit value
+ * costs 40 bytes here against sizeof(Mew) for a plain array.
+ *
+ * On disk the same two arrays follow a 32-byte header, in native byte order:
+ *
+ *   char     magic[8]     "MEWPACK1"
+ *   uint32_t order        0x01020304, rejects foreign-endian files
+ *   uint32_t reserved
+ *   uint64_t count
+ *   uint64_t nlimbs
+ *   uint64_t off[count + 1]
+ *   uint32_t limbs[nlimbs]
+ *
+ * pack_map maps such a file read-only and serves views straight out of the
+ * mapping. Views point into the pack and are invalidated by pack_append.
+ */
+
+#define PACK_MAGIC     "MEWPACK1"
+#define PACK_ORDER     0x01020304u
+#define PACK_SIGN      (1ull << 63)
+#define PACK_OFF(x)    ((x) & ~PACK_SIGN)
+
+typedef struct {
+    char magic[8];
+    uint32_t order;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t nlimbs;
+} PackHeader;
+
+struct MewPack {
+    uint32_t *limbs;
+    uint64_t *off;
+    size_t count;
+    size_t nlimbs;
+    size_t cap_limbs;
+    size_t cap_count;
+
+    void *map;                 /* non-NULL for a read-only mapped pack */
+    size_t map_size;
+};
+
+
+MewPack *pack_new(void) {
+    MewPack *p = calloc(1, sizeof(MewPack));
+    if (!p) return NULL;
+
+    p->cap_count = 16;
+    p->off = malloc((p->cap_count + 1) * sizeof(uint64_t));
+    if (!p->off) {
+        free(p);
+        return NULL;
+    }
+    p->off[0] = 0;
+    return p;
+}
+
+void pack_free(MewPack *p) {
+    if (!p) return;
+    if (p->map) {
+        munmap(p->map, p->map_size);
+    } else {
+        free(p->limbs);
+        free(p->off);
+    }
+    free(p);
+}
+
+static bool pack_reserve(MewPack *p, size_t limbs) {
+    if (p->map) return false;
+
+    if (p->count == p->cap_count) {
+        size_t cap = p->cap_count * 2;
+        uint64_t *off = realloc(p->off, (cap + 1) * sizeof(uint64_t));
+        if (!off) return false;
+        p->off = off;
+        p->cap_count = cap;
+    }
+    if (p->nlimbs + limbs > p->cap_limbs) {
+        size_t cap = p->cap_limbs ? p->cap_limbs : 64;
+        while (cap < p->nlimbs + limbs) cap *= 2;
+        uint32_t *l = realloc(p->limbs, cap * sizeof(uint32_t));
+        if (!l) return false;
+        p->limbs = l;
+        p->cap_limbs = cap;
+    }
+    return true;
+}
+
+static bool pack_push(MewPack *p, const uint32_t *limbs, int n, bool negative) {
+    if (!pack_reserve(p, (size_t)n)) return false;
+
+    if (n) memcpy(p->limbs + p->nlimbs, limbs, (size_t)n * sizeof(uint32_t));
+    p->nlimbs += (size_t)n;
+    ++p->count;
+    p->off[p->count] = p->nlimbs | (negative && n ? PACK_SIGN : 0);
+    return true;
+}
+
+bool pack_append(MewPack *p, const Mew *a) {
+    if (!p || !a || a->chozabretto) return false;
+    return pack_push(p, a->numberArray, digit_len(a), a->negative);
+}
+
+/* one unsigned big-endian value */
+bool pack_append_bytes(MewPack *p, const uint8_t *bytes, size_t len) {
+    if (!p || (!bytes && len)) return false;
+
+    while (len && !*bytes) {
+        ++bytes;
+        --len;
+    }
+    if (len > (size_t)NUM_LEN * 4) return false;
+
+    uint32_t limbs[NUM_LEN];
+    int n = (int)((len + 3) / 4);
+    memset(limbs, 0, (size_t)n * sizeof(uint32_t));
+    for (size_t i = 0; i < len; ++i) {
+        size_t k = len - 1 - i;          /* byte weight */
+        limbs[k / 4] |= (uint32_t)bytes[i] << (8 * (k % 4));
+    }
+    return pack_push(p, limbs, n, false);
+}
+
+/* consecutive big-endian records of width bytes each; returns how many were appended */
+size_t pack_load_bytes(MewPack *p, const uint8_t *buf, size_t len, size_t width) {
+    if (!p || !buf || width == 0) return 0;
+
+    size_t n = 0;
+    for (size_t at = 0; at + width <= len; at += width) {
+        if (!pack_append_bytes(p, buf + at, width)) break;
+        ++n;
+    }
+    return n;
+}
+
+size_t pack_count(const MewPack *p) {
+    return p ? p->count : 0;
+}
+
+size_t pack_bytes(const MewPack *p) {
+    if (!p) return 0;
+    return p->nlimbs * sizeof(uint32_t) + (p->count + 1) * sizeof(uint64_t);
+}
+
+MewView pack_get(const MewPack *p, size_t i) {
+    MewView v = {NULL, 0, false};
+    if (!p || i >= p->count) return v;
+
+    uint64_t start = PACK_OFF(p->off[i]);
+    uint64_t end = p->off[i + 1];
+    v.limbs = p->limbs + start;
+    v.len = (int)(PACK_OFF(end) - start);
+    v.negative = (end & PACK_SIGN) != 0;
+    return v;
+}
+
+Mew pack_load(const MewPack *p, size_t i) {
+    if (!p || i >= p->count) {
+        Mew r = zero();
+        r.chozabretto = true;
+        return r;
+    }
+    MewView v = pack_get(p, i);
+    return from_view(&v);
+}
+
+bool pack_save(const MewPack *p, const char *path) {
+    if (!p || !path) return false;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+
+    PackHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PACK_MAGIC, sizeof(h.magic));
+    h.order = PACK_ORDER;
+    h.count = p->count;
+    h.nlimbs = p->nlimbs;
+
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1
+        && fwrite(p->off, sizeof(uint64_t), p->count + 1, f) == p->count + 1
+        && fwrite(p->limbs, sizeof(uint32_t), p->nlimbs, f) == p->nlimbs;
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+MewPack *pack_map(const char *path) {
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(PackHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    const PackHeader *h = map;
+    bool ok = !memcmp(h->magic, PACK_MAGIC, sizeof(h->magic)) && h->order == PACK_ORDER
+        && h->count < size / sizeof(uint64_t) && h->nlimbs < size / sizeof(uint32_t)
+        && sizeof(PackHeader) + (h->count + 1) * sizeof(uint64_t) + h->nlimbs * sizeof(uint32_t) <= size;
+
+    MewPack *p = ok ? calloc(1, sizeof(MewPack)) : NULL;
+    if (!p) {
+        munmap(map, size);
+        return NULL;
+    }
+
+    p->map = map;
+    p->map_size = size;
+    p->count = h->count;
+    p->nlimbs = h->nlimbs;
+    p->off = (uint64_t *)((char *)map + sizeof(PackHeader));
+    p->limbs = (uint32_t *)(p->off + p->count + 1);
+
+    /* offsets come from the file: check them once so pack_get can trust them */
+    for (size_t i = 0; i < p->count; ++i) {
+        uint64_t a = PACK_OFF(p->off[i]), b = PACK_OFF(p->off[i + 1]);
+        if (a > b || b > p->nlimbs || b - a > NUM_LEN) {
+            pack_free(p);
+            return NULL;
+        }
+    }
+    return p;
+}
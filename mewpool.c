@@ -0,0 +1,151 @@
+#include "mew.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ * Shared worker pool for splitting one large operation across cores. It is
+ * off until pool_init; with one thread every pool_run simply calls its tasks
+ * in order.
+ *
+ * pool_run queues all but the first task, runs the first itself and then
+ * helps drain the queue until its own tasks are done. A waiting caller never
+ * blocks while work is queued, so tasks may call pool_run again (nested
+ * Karatsuba levels) without starving the pool. When the queue is full the
+ * overflow runs inline. Queued tasks travel in PoolJob wrappers on the
+ * caller's stack, which also carry the caller's completion counter.
+ */
+
+#define POOL_MAX_THREADS 64
+#define POOL_QUEUE       64
+
+typedef struct {
+    const MewTask *task;
+    int *pending;
+} PoolJob;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    PoolJob *queue[POOL_QUEUE];
+    int head;
+    int count;
+    bool stop;
+    pthread_t threads[POOL_MAX_THREADS];
+    int nworkers;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static atomic_int pool_size = 1;
+
+/* lock held */
+static PoolJob *pool_pop(void) {
+    if (pool.count == 0) return NULL;
+    PoolJob *t = pool.queue[pool.head];
+    pool.head = (pool.head + 1) % POOL_QUEUE;
+    --pool.count;
+    return t;
+}
+
+/* lock held */
+static void pool_finish(PoolJob *t) {
+    if (--*t->pending == 0) pthread_cond_broadcast(&pool.done);
+}
+
+static void *pool_worker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        PoolJob *t;
+        while (!(t = pool_pop()) && !pool.stop)
+            pthread_cond_wait(&pool.work, &pool.lock);
+        if (!t) break;
+
+        pthread_mutex_unlock(&pool.lock);
+        t->task->fn(t->task->arg);
+        pthread_mutex_lock(&pool.lock);
+        pool_finish(t);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+int pool_init(int threads) {
+    pool_shutdown();
+    if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+
+    pool.stop = false;
+    pool.nworkers = 0;
+    for (int i = 1; i < threads; ++i) {
+        if (pthread_create(&pool.threads[pool.nworkers], NULL, pool_worker, NULL) != 0) break;
+        ++pool.nworkers;
+    }
+    atomic_store(&pool_size, pool.nworkers + 1);
+    return pool.nworkers + 1;
+}
+
+void pool_shutdown(void) {
+    if (pool.nworkers == 0) return;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = true;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int i = 0; i < pool.nworkers; ++i)
+        pthread_join(pool.threads[i], NULL);
+    pool.nworkers = 0;
+    atomic_store(&pool_size, 1);
+}
+
+int pool_threads(void) {
+    return atomic_load_explicit(&pool_size, memory_order_relaxed);
+}
+
+void pool_run(MewTask *tasks, int n) {
+    if (n <= 0) return;
+    if (n == 1 || pool_threads() <= 1) {
+        for (int i = 0; i < n; ++i) tasks[i].fn(tasks[i].arg);
+        return;
+    }
+
+    PoolJob jobs[POOL_QUEUE];
+    int pending = 0;
+    int inline_from = n;
+
+    pthread_mutex_lock(&pool.lock);
+    for (int i = 1; i < n; ++i) {
+        if (pool.count == POOL_QUEUE) {
+            inline_from = i;
+            break;
+        }
+        PoolJob *job = &jobs[i - 1];
+        job->task = &tasks[i];
+        job->pending = &pending;
+        pool.queue[(pool.head + pool.count) % POOL_QUEUE] = job;
+        ++pool.count;
+        ++pending;
+    }
+    if (pending) pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+
+    tasks[0].fn(tasks[0].arg);
+    for (int i = inline_from; i < n; ++i) tasks[i].fn(tasks[i].arg);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pending > 0) {
+        PoolJob *t = pool_pop();
+        if (t) {
+            pthread_mutex_unlock(&pool.lock);
+            t->task->fn(t->task->arg);
+            pthread_mutex_lock(&pool.lock);
+            pool_finish(t);
+        } else {
+            pthread_cond_wait(&pool.done, &pool.lock);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
@@ -0,0 +1,126 @@
+#include "mew.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * xoshiro256** generators. Every thread owns one, so Miller-Rabin workers
+ * never contend on shared state the way rand() does. Streams are 2^128
+ * outputs apart (the xoshiro jump), which gives worker pools disjoint
+ * sequences from one seed.
+ */
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t rng_next(MewRng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+static void rng_jump(MewRng *rng) {
+    static const uint64_t JUMP[4] = {
+        0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+        0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+    };
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 64; ++b) {
+            if (JUMP[i] & (1ull << b))
+                for (int j = 0; j < 4; ++j) s[j] ^= rng->s[j];
+            rng_next(rng);
+        }
+    }
+    memcpy(rng->s, s, sizeof(s));
+}
+
+void rng_seed(MewRng *rng, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed;
+    for (int i = 0; i < 4; ++i) rng->s[i] = splitmix64(&x);
+    for (uint64_t i = 0; i < stream; ++i) rng_jump(rng);
+}
+
+void rng_fill(MewRng *rng, uint32_t *dst, int n) {
+    int i = 0;
+    for (; i + 1 < n; i += 2) {
+        uint64_t v = rng_next(rng);
+        dst[i] = (uint32_t)v;
+        dst[i + 1] = (uint32_t)(v >> 32);
+    }
+    if (i < n) dst[i] = (uint32_t)(rng_next(rng) >> 32);
+}
+
+Mew random_bits_r(MewRng *rng, int bits) {
+    Mew r = zero();
+    if (bits <= 0) return r;
+    if (bits > NUM_LEN * 32) bits = NUM_LEN * 32;
+
+    int nl = (bits + 31) / 32;
+    rng_fill(rng, r.numberArray, nl);
+    if (bits % 32) r.numberArray[nl - 1] &= (1u << (bits % 32)) - 1;
+    return r;
+}
+
+/* uniform in [0, n): draw bit_len(n) bits and reject, so at most two tries are expected */
+Mew random_below_r(MewRng *rng, const Mew *n) {
+    Mew r = zero();
+    if (!n || n->chozabretto || is_zero(n)) { r.chozabretto = true; return r; }
+
+    int bits = bit_len(n);
+    int nl = (bits + 31) / 32;
+    uint32_t mask = (bits % 32) ? (1u << (bits % 32)) - 1 : 0xFFFFFFFFu;
+
+    for (;;) {
+        rng_fill(rng, r.numberArray, nl);
+        r.numberArray[nl - 1] &= mask;
+
+        int i = nl - 1;
+        while (i > 0 && r.numberArray[i] == n->numberArray[i]) --i;
+        if (r.numberArray[i] < n->numberArray[i]) return r;
+    }
+}
+
+
+static _Thread_local MewRng thread_rng;
+static _Thread_local bool thread_rng_ready;
+static atomic_uint_fast64_t thread_rng_streams;
+
+static MewRng *local_rng(void) {
+    if (!thread_rng_ready) {
+        uint64_t stream = atomic_fetch_add(&thread_rng_streams, 1);
+        uint64_t seed = (uint64_t)time(NULL) ^ ((uint64_t)(uintptr_t)&thread_rng << 16) ^ (stream * 0x9E3779B97F4A7C15ull);
+        rng_seed(&thread_rng, seed, 0);
+        thread_rng_ready = true;
+    }
+    return &thread_rng;
+}
+
+void random_seed(uint64_t seed, uint64_t stream) {
+    rng_seed(&thread_rng, seed, stream);
+    thread_rng_ready = true;
+}
+
+Mew random_bits(int bits) {
+    return random_bits_r(local_rng(), bits);
+}
+
+Mew random_below(const Mew *n) {
+    return random_below_r(local_rng(), n);
+}
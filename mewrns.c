@@ -0,0 +1,399 @@
+#include "mew.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Residue number system arithmetic modulo an odd N.
+ *
+ * A value lives as its residues in two bases of k primes just below 2^31,
+ * A = a_1 ... a_k and B = b_1 ... b_k, plus one redundant channel mod 2^32.
+ * Every prime channel keeps its residue in word Montgomery form x R mod p
+ * with R = 2^32, so a channel product is one 32x32 multiply and a REDC and
+ * the channels never carry into each other.
+ *
+ * rns_mul is RNS Montgomery multiplication, x y A^-1 mod N:
+ *
+ *   s = x y                          in A, B and the redundant channel
+ *   q = -s N^-1 mod A                in A
+ *   q' = q + alpha A                 fast base extension A -> B (Bajard),
+ *                                    alpha < k is left uncorrected
+ *   r = (s + q' N) / A               in B and the redundant channel
+ *   r                                exact extension B -> A (Shenoy-Kumaresan),
+ *                                    the redundant channel gives beta exactly
+ *
+ * Values stay below 2kN between products, which A > 4kN and B > 2kN allow.
+ * The two extensions are k x k tables of independent row sums, each a run
+ * of plain 32x32 products with no carries or branches between channels;
+ * wide bases split their rows across the shared pool.
+ *
+ * Values are held as x A mod N (up to a multiple of N); rns_from_mew and
+ * rns_to_mew convert in and out exactly.
+ */
+
+#define RNS_PRIME_TOP   0x7FFFFFFFu
+#define RNS_PAR_ROWS    64        /* narrower bases extend on the caller */
+#define RNS_MAX_TASKS   8
+
+struct MewRns {
+    int k;
+    uint32_t pa[RNS_MAX_CHANNELS];     /* base A */
+    uint32_t pb[RNS_MAX_CHANNELS];     /* base B */
+    uint32_t na[RNS_MAX_CHANNELS];     /* -p^-1 mod 2^32 */
+    uint32_t nb[RNS_MAX_CHANNELS];
+
+    uint32_t qa[RNS_MAX_CHANNELS];     /* -N^-1 (A/a_i)^-1 mod a_i */
+    uint32_t ra[RNS_MAX_CHANNELS];     /* A/a_i mod 2^32 */
+    uint32_t nbar[RNS_MAX_CHANNELS];   /* N R mod b_j */
+    uint32_t ainv[RNS_MAX_CHANNELS];   /* A^-1 R mod b_j */
+    uint32_t eb[RNS_MAX_CHANNELS];     /* (B/b_j)^-1 mod b_j */
+    uint32_t rb[RNS_MAX_CHANNELS];     /* B/b_j mod 2^32 */
+    uint32_t vb[RNS_MAX_CHANNELS];     /* B R^2 mod a_i */
+    uint32_t n_r;                      /* N mod 2^32 */
+    uint32_t ainv_r;                   /* A^-1 mod 2^32 */
+    uint32_t binv_r;                   /* B^-1 mod 2^32 */
+
+    uint32_t *ext_ab;                  /* row j: (A/a_i) R mod b_j */
+    uint32_t *ext_ba;                  /* row i: (B/b_j) R mod a_i */
+
+    MewMod m;
+    MewPack *bn;                       /* (B/b_j) mod N */
+    Mew neg_b;                         /* N - (B mod N) */
+    MewRnsValue a2;                    /* A^2 mod N */
+    MewRnsValue one;
+};
+
+typedef struct {
+    const MewRns *c;
+    const uint32_t *xi;                /* plain digits of the source base */
+    const uint32_t *t;                 /* extension table, one row per target */
+    const uint32_t *p;
+    uint32_t *out;
+    int lo;
+    int hi;
+} ExtendRows;
+
+
+static uint32_t redc(uint64_t x, uint32_t p, uint32_t pn) {
+    uint32_t m = (uint32_t)x * pn;
+    uint32_t t = (uint32_t)((x + (uint64_t)m * p) >> 32);
+    return t >= p ? t - p : t;
+}
+
+static uint32_t add_p(uint32_t a, uint32_t b, uint32_t p) {
+    uint32_t s = a + b;
+    return s >= p ? s - p : s;
+}
+
+static uint32_t mulmod_u32(uint32_t a, uint32_t b, uint32_t p) {
+    return (uint32_t)((uint64_t)a * b % p);
+}
+
+static uint32_t powmod_u32(uint32_t a, uint32_t e, uint32_t p) {
+    uint32_t r = 1 % p;
+    for (; e; e >>= 1) {
+        if (e & 1) r = mulmod_u32(r, a, p);
+        a = mulmod_u32(a, a, p);
+    }
+    return r;
+}
+
+static uint32_t inv_mod_u32(uint32_t a, uint32_t p) {
+    return powmod_u32(a % p, p - 2, p);
+}
+
+/* a^-1 mod 2^32 for odd a */
+static uint32_t inv_word(uint32_t a) {
+    uint32_t x = a;
+    for (int i = 0; i < 4; ++i) x *= 2 - a * x;
+    return x;
+}
+
+/* deterministic for n < 4759123141 */
+static bool is_prime_u32(uint32_t n) {
+    if (n < 2) return false;
+    if (n % 2 == 0) return n == 2;
+    uint32_t d = n - 1;
+    int s = 0;
+    while (!(d & 1)) {
+        d >>= 1;
+        ++s;
+    }
+    static const uint32_t bases[] = {2, 7, 61};
+    for (int i = 0; i < 3; ++i) {
+        uint32_t a = bases[i] % n;
+        if (a == 0) continue;
+        uint32_t x = powmod_u32(a, d, n);
+        if (x == 1 || x == n - 1) continue;
+        int j = 1;
+        for (; j < s; ++j) {
+            x = mulmod_u32(x, x, n);
+            if (x == n - 1) break;
+        }
+        if (j == s) return false;
+    }
+    return true;
+}
+
+static uint32_t mew_mod_u32(const Mew *a, uint32_t p) {
+    uint64_t r = 0;
+    for (int i = digit_len(a) - 1; i >= 0; --i)
+        r = ((r << 32) | a->numberArray[i]) % p;
+    return (uint32_t)r;
+}
+
+/* x R mod p */
+static uint32_t to_channel(uint32_t x, uint32_t p) {
+    return (uint32_t)(((uint64_t)x << 32) % p);
+}
+
+static Mew product(const uint32_t *p, int k) {
+    Mew r = from_u32(1);
+    for (int i = 0; i < k; ++i) r = mul_one(&r, p[i]);
+    return r;
+}
+
+/* residues of a plain 0 <= x, straight into channel form */
+static MewRnsValue residues(const MewRns *c, const Mew *x) {
+    MewRnsValue v;
+    memset(&v, 0, sizeof(v));
+    for (int i = 0; i < c->k; ++i) {
+        v.a[i] = to_channel(mew_mod_u32(x, c->pa[i]), c->pa[i]);
+        v.b[i] = to_channel(mew_mod_u32(x, c->pb[i]), c->pb[i]);
+    }
+    v.r = x->numberArray[0];
+    return v;
+}
+
+
+static void extend_rows(void *arg) {
+    ExtendRows *e = arg;
+    int k = e->c->k;
+    for (int j = e->lo; j < e->hi; ++j) {
+        const uint32_t *row = e->t + (size_t)j * k;
+        uint32_t p = e->p[j];
+        /* sum the 62-bit products split at bit 31: no carries, no branches */
+        uint64_t hi = 0, lo = 0;
+        for (int i = 0; i < k; ++i) {
+            uint64_t t = (uint64_t)e->xi[i] * row[i];
+            hi += t >> 31;
+            lo += t & 0x7FFFFFFFu;
+        }
+        uint64_t top = (hi % p) << 31;
+        e->out[j] = (uint32_t)((top % p + lo % p) % p);
+    }
+}
+
+/* out[j] = sum_i xi[i] t[j][i] over the target channels */
+static void extend(const MewRns *c, const uint32_t *xi, const uint32_t *t,
+                   const uint32_t *p, uint32_t *out) {
+    int tasks = pool_threads();
+    if (tasks > RNS_MAX_TASKS) tasks = RNS_MAX_TASKS;
+    if (c->k < RNS_PAR_ROWS || tasks <= 1) {
+        ExtendRows e = {c, xi, t, p, out, 0, c->k};
+        extend_rows(&e);
+        return;
+    }
+
+    ExtendRows args[RNS_MAX_TASKS];
+    MewTask run[RNS_MAX_TASKS];
+    for (int i = 0; i < tasks; ++i) {
+        args[i] = (ExtendRows){c, xi, t, p, out, c->k * i / tasks, c->k * (i + 1) / tasks};
+        run[i].fn = extend_rows;
+        run[i].arg = &args[i];
+    }
+    pool_run(run, tasks);
+}
+
+
+MewRns *rns_new(const Mew *n) {
+    if (!n || n->chozabretto || !(n->numberArray[0] & 1)) return NULL;
+    Mew one = from_u32(1);
+    int bits = bit_len(n);
+    if (cmp(n, &one) <= 0 || bits > RNS_MAX_BITS) return NULL;
+
+    MewRns *c = calloc(1, sizeof(MewRns));
+    if (!c) return NULL;
+
+    /* every prime exceeds 2^30, and 4k <= 2^10: A, B > 2^(30k) >= 4kN */
+    int k = 1;
+    while (30 * k < bits + 10) ++k;
+    c->k = k;
+
+    uint32_t p = RNS_PRIME_TOP;
+    for (int i = 0; i < 2 * k; p -= 2) {
+        if (!is_prime_u32(p) || mew_mod_u32(n, p) == 0) continue;
+        if (i < k) c->pa[i] = p;
+        else c->pb[i - k] = p;
+        ++i;
+    }
+
+    c->ext_ab = malloc((size_t)k * k * sizeof(uint32_t));
+    c->ext_ba = malloc((size_t)k * k * sizeof(uint32_t));
+    c->bn = pack_new();
+    c->m = mod_context(n);
+    if (!c->ext_ab || !c->ext_ba || !c->bn || c->m.chozabretto) {
+        rns_free(c);
+        return NULL;
+    }
+
+    Mew A = product(c->pa, k);
+    Mew B = product(c->pb, k);
+    Mew a_mod_n = mod_reduce(&c->m, &A);
+    Mew b_mod_n = mod_reduce(&c->m, &B);
+    c->neg_b = sub(&c->m.n, &b_mod_n);
+    Mew a2 = mod_multiply_ctx(&c->m, &a_mod_n, &a_mod_n);
+
+    c->n_r = n->numberArray[0];
+    c->ainv_r = inv_word(A.numberArray[0]);
+    c->binv_r = inv_word(B.numberArray[0]);
+
+    for (int i = 0; i < k; ++i) {
+        uint32_t pa = c->pa[i], pb = c->pb[i];
+        c->na[i] = -inv_word(pa);
+        c->nb[i] = -inv_word(pb);
+
+        uint32_t r1a = to_channel(1, pa), r1b = to_channel(1, pb);
+        uint32_t a_at_a = 1, b_at_b = 1;
+        uint32_t ra = 1, rb = 1;
+        for (int l = 0; l < k; ++l) {
+            if (l == i) continue;
+            a_at_a = mulmod_u32(a_at_a, c->pa[l] % pa, pa);
+            b_at_b = mulmod_u32(b_at_b, c->pb[l] % pb, pb);
+            ra *= c->pa[l];
+            rb *= c->pb[l];
+        }
+        uint32_t ninv = inv_mod_u32(mew_mod_u32(n, pa), pa);
+        c->qa[i] = mulmod_u32(pa - ninv, inv_mod_u32(a_at_a, pa), pa);
+        c->ra[i] = ra;
+        c->eb[i] = inv_mod_u32(b_at_b, pb);
+        c->rb[i] = rb;
+
+        c->nbar[i] = to_channel(mew_mod_u32(n, pb), pb);
+        c->ainv[i] = to_channel(inv_mod_u32(mew_mod_u32(&A, pb), pb), pb);
+        c->vb[i] = mulmod_u32(mulmod_u32(mew_mod_u32(&B, pa), r1a, pa), r1a, pa);
+
+        /* row i of ext_ba and row i of ext_ab: (X/x_l) = (X mod p) x_l^-1 */
+        uint32_t b_at_a = mew_mod_u32(&B, pa), a_at_b = mew_mod_u32(&A, pb);
+        for (int l = 0; l < k; ++l) {
+            c->ext_ba[(size_t)i * k + l] =
+                mulmod_u32(mulmod_u32(b_at_a, inv_mod_u32(c->pb[l], pa), pa), r1a, pa);
+            c->ext_ab[(size_t)i * k + l] =
+                mulmod_u32(mulmod_u32(a_at_b, inv_mod_u32(c->pa[l], pb), pb), r1b, pb);
+        }
+
+        Mew bj = product(c->pb, i);
+        for (int l = i + 1; l < k; ++l) bj = mul_one(&bj, c->pb[l]);
+        bj = mod_reduce(&c->m, &bj);
+        if (!pack_append(c->bn, &bj)) {
+            rns_free(c);
+            return NULL;
+        }
+    }
+
+    c->one = residues(c, &one);
+    c->a2 = residues(c, &a2);
+    return c;
+}
+
+void rns_free(MewRns *c) {
+    if (!c) return;
+    free(c->ext_ab);
+    free(c->ext_ba);
+    pack_free(c->bn);
+    free(c);
+}
+
+int rns_channels(const MewRns *c) {
+    return c ? c->k : 0;
+}
+
+MewRnsValue rns_mul(const MewRns *c, const MewRnsValue *x, const MewRnsValue *y) {
+    MewRnsValue r;
+    r.chozabretto = !c || !x || !y || x->chozabretto || y->chozabretto;
+    if (r.chozabretto) return r;
+
+    int k = c->k;
+    uint32_t xi[RNS_MAX_CHANNELS] = {0}, q[RNS_MAX_CHANNELS];
+
+    /* q = -s N^-1 mod A, already scaled by (A/a_i)^-1 for the extension */
+    uint32_t q_r = 0;
+    for (int i = 0; i < k; ++i) {
+        uint32_t s = redc((uint64_t)x->a[i] * y->a[i], c->pa[i], c->na[i]);
+        xi[i] = redc((uint64_t)s * c->qa[i], c->pa[i], c->na[i]);
+        q_r += xi[i] * c->ra[i];
+    }
+    extend(c, xi, c->ext_ab, c->pb, q);
+
+    /* r = (s + q N) / A in B */
+    uint32_t eta_r = 0;
+    for (int j = 0; j < k; ++j) {
+        uint32_t pb = c->pb[j], nb = c->nb[j];
+        uint32_t s = redc((uint64_t)x->b[j] * y->b[j], pb, nb);
+        uint32_t t = add_p(s, redc((uint64_t)q[j] * c->nbar[j], pb, nb), pb);
+        r.b[j] = redc((uint64_t)t * c->ainv[j], pb, nb);
+        xi[j] = redc((uint64_t)r.b[j] * c->eb[j], pb, nb);
+        eta_r += xi[j] * c->rb[j];
+    }
+    r.r = (x->r * y->r + q_r * c->n_r) * c->ainv_r;
+
+    /* sum_j eta_j B/b_j = r + beta B, beta < k */
+    uint32_t beta = (eta_r - r.r) * c->binv_r;
+    extend(c, xi, c->ext_ba, c->pa, r.a);
+    for (int i = 0; i < k; ++i) {
+        uint32_t pa = c->pa[i];
+        uint32_t bb = redc((uint64_t)beta * c->vb[i], pa, c->na[i]);
+        r.a[i] = add_p(r.a[i], pa - bb, pa);
+    }
+    return r;
+}
+
+MewRnsValue rns_from_mew(const MewRns *c, const Mew *a) {
+    MewRnsValue r;
+    r.chozabretto = !c || !a || a->chozabretto;
+    if (r.chozabretto) return r;
+
+    Mew x = mod_reduce(&c->m, a);
+    r = residues(c, &x);
+    return rns_mul(c, &r, &c->a2);
+}
+
+Mew rns_to_mew(const MewRns *c, const MewRnsValue *x) {
+    Mew r = zero();
+    if (!c || !x || x->chozabretto) {
+        r.chozabretto = true;
+        return r;
+    }
+
+    MewRnsValue v = rns_mul(c, x, &c->one);
+
+    /* CRT over B; beta B is dropped as beta (N - B mod N) */
+    uint32_t eta_r = 0;
+    for (int j = 0; j < c->k; ++j) {
+        uint32_t eta = redc((uint64_t)v.b[j] * c->eb[j], c->pb[j], c->nb[j]);
+        MewView bj = pack_get(c->bn, (size_t)j);
+        Mew t = from_view(&bj);
+        t = mul_one(&t, eta);
+        r = add(&r, &t);
+        eta_r += eta * c->rb[j];
+    }
+    uint32_t beta = (eta_r - v.r) * c->binv_r;
+    Mew nb = mul_one(&c->neg_b, beta);
+    r = add(&r, &nb);
+    return mod_reduce(&c->m, &r);
+}
+
+Mew rns_pow(const MewRns *c, const Mew *base, const Mew *exp) {
+    Mew r = zero();
+    if (!c || !base || !exp || base->chozabretto || exp->chozabretto) {
+        r.chozabretto = true;
+        return r;
+    }
+
+    MewRnsValue b = rns_from_mew(c, base);
+    MewRnsValue acc = rns_mul(c, &c->one, &c->a2);      /* 1 A mod N */
+    for (int i = bit_len(exp) - 1; i >= 0; --i) {
+        acc = rns_mul(c, &acc, &acc);
+        if (bit_at(exp, i)) acc = rns_mul(c, &acc, &b);
+    }
+    return rns_to_mew(c, &acc);
+}
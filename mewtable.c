@@ -0,0 +1,182 @@
+#include "mew.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Hashing and hash tables for Mew keys.
+ *
+ * hash_view mixes the significant limbs two at a time, so a 256-bit key costs
+ * four rounds no matter how wide NUM_LEN is, and equal values hash equally
+ * whatever their source (Mew, pack view, mapped file). The seed keys the whole
+ * function; tables pick theirs at creation.
+ *
+ * MewTable is open addressing with linear probing. Keys live in a MewPack,
+ * slots keep the full 64-bit hash, so probing compares limbs only on a hash
+ * match and growing never rehashes a key.
+ *
+ * A fingerprint table (table_new_fingerprint) keeps no keys at all: the 64-bit
+ * hash stands in for the key, so lookups may report a false match and the
+ * caller must confirm hits. Memory is then the slot array alone, whatever
+ * the key width.
+ */
+
+#define TABLE_MIN_CAP 16
+#define TABLE_EMPTY   UINT32_MAX
+
+typedef struct {
+    uint64_t hash;
+    uint64_t value;
+    uint32_t key;              /* index into keys, TABLE_EMPTY if free, 0 in a fingerprint table */
+} TableSlot;
+
+struct MewTable {
+    MewPack *keys;             /* NULL for a fingerprint table */
+    TableSlot *slots;
+    size_t cap;                /* power of two */
+    size_t count;
+    uint64_t seed;
+};
+
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t hash_view(const MewView *v, uint64_t seed) {
+    int n = v->len;
+    while (n > 0 && !v->limbs[n - 1]) --n;
+
+    uint64_t h = mix64(seed ^ ((uint64_t)n << 1 | (v->negative && n)));
+    int i = 0;
+    for (; i + 1 < n; i += 2) {
+        uint64_t w = (uint64_t)v->limbs[i] | (uint64_t)v->limbs[i + 1] << 32;
+        h = (h ^ mix64(w)) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 29;
+    }
+    if (i < n) h = (h ^ mix64(v->limbs[i])) * 0x9E3779B97F4A7C15ull;
+    return mix64(h);
+}
+
+uint64_t hash_mew(const Mew *a, uint64_t seed) {
+    MewView v = view_of(a);
+    return hash_view(&v, seed);
+}
+
+
+static TableSlot *table_slots(size_t cap) {
+    TableSlot *s = malloc(cap * sizeof(TableSlot));
+    if (!s) return NULL;
+    for (size_t i = 0; i < cap; ++i) s[i].key = TABLE_EMPTY;
+    return s;
+}
+
+static MewTable *table_alloc(size_t expected, uint64_t seed, bool keys) {
+    MewTable *t = calloc(1, sizeof(MewTable));
+    if (!t) return NULL;
+
+    t->cap = TABLE_MIN_CAP;
+    while (t->cap < expected + expected / 2) t->cap *= 2;
+    t->seed = seed;
+    t->keys = keys ? pack_new() : NULL;
+    t->slots = table_slots(t->cap);
+    if ((keys && !t->keys) || !t->slots) {
+        table_free(t);
+        return NULL;
+    }
+    return t;
+}
+
+MewTable *table_new(size_t expected, uint64_t seed) {
+    return table_alloc(expected, seed, true);
+}
+
+MewTable *table_new_fingerprint(size_t expected, uint64_t seed) {
+    return table_alloc(expected, seed, false);
+}
+
+void table_free(MewTable *t) {
+    if (!t) return;
+    pack_free(t->keys);
+    free(t->slots);
+    free(t);
+}
+
+size_t table_count(const MewTable *t) {
+    return t ? t->count : 0;
+}
+
+size_t table_bytes(const MewTable *t) {
+    if (!t) return 0;
+    return sizeof(MewTable) + t->cap * sizeof(TableSlot) + pack_bytes(t->keys);
+}
+
+/* slot holding key, or the free slot where it would go */
+static TableSlot *table_find(const MewTable *t, const MewView *key, uint64_t h) {
+    size_t mask = t->cap - 1;
+    for (size_t i = (size_t)h & mask;; i = (i + 1) & mask) {
+        TableSlot *s = &t->slots[i];
+        if (s->key == TABLE_EMPTY) return s;
+        if (s->hash == h) {
+            if (!t->keys) return s;
+            MewView k = pack_get(t->keys, s->key);
+            if (k.negative == (key->negative && key->len) && cmp_view(&k, key) == 0) return s;
+        }
+    }
+}
+
+static bool table_grow(MewTable *t) {
+    size_t cap = t->cap * 2;
+    TableSlot *slots = table_slots(cap);
+    if (!slots) return false;
+
+    for (size_t i = 0; i < t->cap; ++i) {
+        TableSlot *s = &t->slots[i];
+        if (s->key == TABLE_EMPTY) continue;
+        size_t j = (size_t)s->hash & (cap - 1);
+        while (slots[j].key != TABLE_EMPTY) j = (j + 1) & (cap - 1);
+        slots[j] = *s;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->cap = cap;
+    return true;
+}
+
+bool table_put(MewTable *t, const Mew *key, uint64_t value) {
+    if (!t || !key || key->chozabretto) return false;
+    if ((t->count + 1) * 10 > t->cap * 7 && !table_grow(t)) return false;
+
+    MewView k = view_of(key);
+    uint64_t h = hash_view(&k, t->seed);
+    TableSlot *s = table_find(t, &k, h);
+    if (s->key != TABLE_EMPTY) {
+        s->value = value;
+        return true;
+    }
+
+    if (!t->keys) {
+        s->key = 0;
+    } else {
+        if (pack_count(t->keys) >= TABLE_EMPTY || !pack_append(t->keys, key)) return false;
+        s->key = (uint32_t)(pack_count(t->keys) - 1);
+    }
+    s->hash = h;
+    s->value = value;
+    ++t->count;
+    return true;
+}
+
+bool table_get(const MewTable *t, const Mew *key, uint64_t *value) {
+    if (!t || !key || key->chozabretto) return false;
+
+    MewView k = view_of(key);
+    TableSlot *s = table_find(t, &k, hash_view(&k, t->seed));
+    if (s->key == TABLE_EMPTY) return false;
+    if (value) *value = s->value;
+    return true;
+}
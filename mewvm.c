@@ -0,0 +1,432 @@
+#include "mew.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Compiled expressions. A formula such as "((a * b + c) % n) ^ e % n" is parsed
+ * once into register bytecode over a fixed file of Mew slots; vm_run then
+ * evaluates it for new inputs without parsing or allocating.
+ *
+ * Grammar (usual precedence, ^ binds tightest and is right-associative):
+ *
+ *   expr    := term (('+' | '-') term)*
+ *   term    := power (('*' | '/' | '%') power)*
+ *   power   := primary ('^' power)?
+ *   primary := number | name | '(' expr ')'
+ *
+ * Numbers are hex and must start with a decimal digit (0ff, 0x10001); names
+ * are identifiers and become inputs set with vm_set.
+ *
+ * "x % n" with n a name or a literal is compiled in modular form: everything
+ * under it becomes context operations against n, additions stay lazy in
+ * [0, 4n), products and powers come back reduced, and a nested "% n" on the
+ * same modulus is dropped. Only the final value is normalized.
+ */
+
+#define VM_REGS   32
+#define VM_NODES  128
+#define VM_CODE   128
+#define VM_INPUTS 16
+#define VM_MODS   4
+#define VM_NAME   16
+
+typedef enum {
+    VM_ADD, VM_SUB, VM_MUL, VM_DIV, VM_MOD, VM_POW,
+    VM_MADD, VM_MSUB, VM_MMUL, VM_MPOW, VM_MRED, VM_MNORM
+} VmOp;
+
+typedef struct {
+    uint8_t op;
+    uint8_t dst;
+    uint8_t a;
+    uint8_t b;
+    uint8_t m;
+} VmInsn;
+
+typedef struct {
+    int reg;
+    MewMod ctx;
+    bool valid;
+} VmMod;
+
+struct MewProgram {
+    Mew regs[VM_REGS];
+    VmInsn code[VM_CODE];
+    int ncode;
+    int result;
+
+    char names[VM_INPUTS][VM_NAME];
+    int input_reg[VM_INPUTS];
+    int ninputs;
+
+    VmMod mods[VM_MODS];
+    int nmods;
+};
+
+typedef enum { N_REG, N_BIN } NodeKind;
+
+typedef struct {
+    NodeKind kind;
+    char op;
+    int reg;
+    int left;
+    int right;
+} Node;
+
+typedef struct {
+    MewProgram *p;
+    const char *s;
+    Node nodes[VM_NODES];
+    int nnodes;
+    bool used[VM_REGS];
+    bool fixed[VM_REGS];
+    bool failed;
+} Compiler;
+
+typedef struct {
+    int reg;
+    bool lazy;
+} Val;
+
+
+static void skip_space(Compiler *c) {
+    while (*c->s == ' ' || *c->s == '\t' || *c->s == '\n' || *c->s == '\r') ++c->s;
+}
+
+static int alloc_reg(Compiler *c) {
+    for (int i = 0; i < VM_REGS; ++i) {
+        if (!c->used[i]) {
+            c->used[i] = true;
+            return i;
+        }
+    }
+    c->failed = true;
+    return 0;
+}
+
+static void release(Compiler *c, int reg) {
+    if (!c->fixed[reg]) c->used[reg] = false;
+}
+
+static int fixed_reg(Compiler *c) {
+    int r = alloc_reg(c);
+    c->fixed[r] = true;
+    return r;
+}
+
+static int new_node(Compiler *c, NodeKind kind, char op, int reg, int left, int right) {
+    if (c->nnodes == VM_NODES) {
+        c->failed = true;
+        return 0;
+    }
+    Node *n = &c->nodes[c->nnodes];
+    n->kind = kind;
+    n->op = op;
+    n->reg = reg;
+    n->left = left;
+    n->right = right;
+    return c->nnodes++;
+}
+
+static bool is_ident(char ch, bool first) {
+    if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_') return true;
+    return !first && ch >= '0' && ch <= '9';
+}
+
+static bool is_hex(char ch) {
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+static int parse_expr(Compiler *c);
+
+static int parse_number(Compiler *c) {
+    const char *start = c->s;
+    if (start[0] == '0' && (start[1] == 'x' || start[1] == 'X')) start += 2;
+    const char *end = start;
+    while (is_hex(*end)) ++end;
+    c->s = end;
+
+    Mew v = from_hex_n(start, (size_t)(end - start));
+    if (end == start || v.chozabretto) {
+        c->failed = true;
+        return 0;
+    }
+
+    /* equal literals share a register, so "% 0ff" twice is one modulus */
+    for (int i = 0; i < VM_REGS; ++i) {
+        if (c->fixed[i] && cmp(&c->p->regs[i], &v) == 0) {
+            bool is_input = false;
+            for (int j = 0; j < c->p->ninputs; ++j)
+                if (c->p->input_reg[j] == i) is_input = true;
+            if (!is_input) return new_node(c, N_REG, 0, i, -1, -1);
+        }
+    }
+
+    int r = fixed_reg(c);
+    c->p->regs[r] = v;
+    return new_node(c, N_REG, 0, r, -1, -1);
+}
+
+static int parse_name(Compiler *c) {
+    const char *start = c->s;
+    while (is_ident(*c->s, false)) ++c->s;
+    size_t len = (size_t)(c->s - start);
+    if (len >= VM_NAME) {
+        c->failed = true;
+        return 0;
+    }
+
+    MewProgram *p = c->p;
+    for (int i = 0; i < p->ninputs; ++i)
+        if (strlen(p->names[i]) == len && !memcmp(p->names[i], start, len))
+            return new_node(c, N_REG, 0, p->input_reg[i], -1, -1);
+
+    if (p->ninputs == VM_INPUTS) {
+        c->failed = true;
+        return 0;
+    }
+    int r = fixed_reg(c);
+    memcpy(p->names[p->ninputs], start, len);
+    p->names[p->ninputs][len] = 0;
+    p->input_reg[p->ninputs++] = r;
+    return new_node(c, N_REG, 0, r, -1, -1);
+}
+
+static int parse_primary(Compiler *c) {
+    skip_space(c);
+    if (*c->s == '(') {
+        ++c->s;
+        int n = parse_expr(c);
+        skip_space(c);
+        if (*c->s != ')') {
+            c->failed = true;
+            return 0;
+        }
+        ++c->s;
+        return n;
+    }
+    if (*c->s >= '0' && *c->s <= '9') return parse_number(c);
+    if (is_ident(*c->s, true)) return parse_name(c);
+
+    c->failed = true;
+    return 0;
+}
+
+static int parse_power(Compiler *c) {
+    int base = parse_primary(c);
+    skip_space(c);
+    if (*c->s == '^') {
+        ++c->s;
+        int exp = parse_power(c);
+        return new_node(c, N_BIN, '^', -1, base, exp);
+    }
+    return base;
+}
+
+static int parse_term(Compiler *c) {
+    int n = parse_power(c);
+    for (;;) {
+        skip_space(c);
+        char op = *c->s;
+        if (op != '*' && op != '/' && op != '%') return n;
+        ++c->s;
+        int r = parse_power(c);
+        n = new_node(c, N_BIN, op, -1, n, r);
+        if (c->failed) return n;
+    }
+}
+
+static int parse_expr(Compiler *c) {
+    int n = parse_term(c);
+    for (;;) {
+        skip_space(c);
+        char op = *c->s;
+        if (op != '+' && op != '-') return n;
+        ++c->s;
+        int r = parse_term(c);
+        n = new_node(c, N_BIN, op, -1, n, r);
+        if (c->failed) return n;
+    }
+}
+
+
+static void emit(Compiler *c, VmOp op, int dst, int a, int b, int m) {
+    MewProgram *p = c->p;
+    if (p->ncode == VM_CODE) {
+        c->failed = true;
+        return;
+    }
+    p->code[p->ncode++] = (VmInsn){ (uint8_t)op, (uint8_t)dst, (uint8_t)a, (uint8_t)b, (uint8_t)m };
+}
+
+static int mod_slot(Compiler *c, int reg) {
+    MewProgram *p = c->p;
+    for (int i = 0; i < p->nmods; ++i)
+        if (p->mods[i].reg == reg) return i;
+    if (p->nmods == VM_MODS) {
+        c->failed = true;
+        return 0;
+    }
+    p->mods[p->nmods].reg = reg;
+    p->mods[p->nmods].valid = false;
+    return p->nmods++;
+}
+
+static bool is_modulus(const Compiler *c, int node) {
+    return c->nodes[node].kind == N_REG;
+}
+
+static int gen(Compiler *c, int node);
+
+/* value congruent to node mod regs[mreg]; lazy values lie in [0, 4n), others in [0, n) */
+static Val gen_mod(Compiler *c, int node, int mreg, int slot) {
+    const Node *n = &c->nodes[node];
+
+    if (n->kind == N_BIN) {
+        if (n->op == '%' && is_modulus(c, n->right) && c->nodes[n->right].reg == mreg)
+            return gen_mod(c, n->left, mreg, slot);
+
+        if (n->op == '+' || n->op == '-' || n->op == '*') {
+            Val l = gen_mod(c, n->left, mreg, slot);
+            Val r = gen_mod(c, n->right, mreg, slot);
+            release(c, l.reg);
+            release(c, r.reg);
+            int dst = alloc_reg(c);
+            VmOp op = n->op == '+' ? VM_MADD : n->op == '-' ? VM_MSUB : VM_MMUL;
+            emit(c, op, dst, l.reg, r.reg, slot);
+            return (Val){ dst, op != VM_MMUL };
+        }
+
+        if (n->op == '^') {
+            Val b = gen_mod(c, n->left, mreg, slot);
+            int e = gen(c, n->right);
+            release(c, b.reg);
+            release(c, e);
+            int dst = alloc_reg(c);
+            emit(c, VM_MPOW, dst, b.reg, e, slot);
+            return (Val){ dst, false };
+        }
+    }
+
+    int r = gen(c, node);
+    release(c, r);
+    int dst = alloc_reg(c);
+    emit(c, VM_MRED, dst, r, 0, slot);
+    return (Val){ dst, false };
+}
+
+static int gen(Compiler *c, int node) {
+    const Node *n = &c->nodes[node];
+    if (n->kind == N_REG) return n->reg;
+
+    if (n->op == '%' && is_modulus(c, n->right)) {
+        int mreg = c->nodes[n->right].reg;
+        int slot = mod_slot(c, mreg);
+        Val v = gen_mod(c, n->left, mreg, slot);
+        if (v.lazy) emit(c, VM_MNORM, v.reg, v.reg, 0, slot);
+        return v.reg;
+    }
+
+    int l = gen(c, n->left);
+    int r = gen(c, n->right);
+    release(c, l);
+    release(c, r);
+    int dst = alloc_reg(c);
+
+    VmOp op;
+    switch (n->op) {
+    case '+': op = VM_ADD; break;
+    case '-': op = VM_SUB; break;
+    case '*': op = VM_MUL; break;
+    case '/': op = VM_DIV; break;
+    case '%': op = VM_MOD; break;
+    default:  op = VM_POW; break;
+    }
+    emit(c, op, dst, l, r, 0);
+    return dst;
+}
+
+MewProgram *vm_compile(const char *src) {
+    if (!src) return NULL;
+
+    MewProgram *p = calloc(1, sizeof(MewProgram));
+    Compiler *c = calloc(1, sizeof(Compiler));
+    if (!p || !c) {
+        free(p);
+        free(c);
+        return NULL;
+    }
+    c->p = p;
+    c->s = src;
+
+    int root = parse_expr(c);
+    skip_space(c);
+    if (*c->s) c->failed = true;
+    if (!c->failed) p->result = gen(c, root);
+
+    bool failed = c->failed;
+    free(c);
+    if (failed) {
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+void vm_free(MewProgram *p) {
+    free(p);
+}
+
+bool vm_set(MewProgram *p, const char *name, const Mew *v) {
+    if (!p || !name || !v) return false;
+    for (int i = 0; i < p->ninputs; ++i) {
+        if (!strcmp(p->names[i], name)) {
+            p->regs[p->input_reg[i]] = *v;
+            return true;
+        }
+    }
+    return false;
+}
+
+Mew vm_run(MewProgram *p) {
+    Mew err = zero();
+    err.chozabretto = true;
+    if (!p) return err;
+
+    /* contexts are rebuilt only when a modulus input actually changed */
+    for (int i = 0; i < p->nmods; ++i) {
+        VmMod *m = &p->mods[i];
+        if (!m->valid || cmp(&m->ctx.n, &p->regs[m->reg]) != 0) {
+            m->ctx = mod_context(&p->regs[m->reg]);
+            m->valid = !m->ctx.chozabretto;
+            if (!m->valid) return err;
+        }
+    }
+
+    Mew *R = p->regs;
+    for (int i = 0; i < p->ncode; ++i) {
+        const VmInsn *in = &p->code[i];
+        const MewMod *m = &p->mods[in->m].ctx;
+        Mew v;
+
+        switch ((VmOp)in->op) {
+        case VM_ADD:   v = add(&R[in->a], &R[in->b]); break;
+        case VM_SUB:   v = sub(&R[in->a], &R[in->b]); break;
+        case VM_MUL:   v = mul(&R[in->a], &R[in->b]); break;
+        case VM_DIV:   v = divm(&R[in->a], &R[in->b]); break;
+        case VM_MOD:   v = modm(&R[in->a], &R[in->b]); break;
+        case VM_POW:   v = powm(&R[in->a], &R[in->b]); break;
+        case VM_MADD:  v = mod_add_lazy(m, &R[in->a], &R[in->b]); break;
+        case VM_MSUB:  v = mod_subtract_lazy(m, &R[in->a], &R[in->b]); break;
+        case VM_MMUL:  v = mod_multiply_ctx(m, &R[in->a], &R[in->b]); break;
+        case VM_MPOW:  v = mod_pow_ctx(m, &R[in->a], &R[in->b]); break;
+        case VM_MRED:  v = mod_reduce(m, &R[in->a]); break;
+        case VM_MNORM: v = mod_normalize_lazy(m, &R[in->a]); break;
+        default:       return err;
+        }
+        if (v.chozabretto) return err;
+        R[in->dst] = v;
+    }
+
+    return copy(&R[p->result]);
+}
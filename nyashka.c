@@ -6,15 +6,8 @@
 
 #define NUM_TESTS 1000
 
-uint32_t rand_u32(uint32_t min, uint32_t max) {
-    return min + rand() % (max - min + 1);
-}
-
 Mew random_mew(int digits) {
-    Mew result = zero();
-    for (int i = 0; i < digits && i < NUM_LEN; i++) {
-        result.numberArray[i] = rand_u32(1, 0xFFFFFFFF);
-    }
+    Mew result = random_bits(digits * 32);
     if (is_zero(&result)) result.numberArray[0] = 1;
     return result;
 }
@@ -65,7 +58,7 @@ double timer_div(int digits, int num_tests) {
 int main() {
     printf("Time\n");
     
-    srand((unsigned int)time(NULL));
+    random_seed((uint64_t)time(NULL), 0);
     
     int digits_list[] = {3, 16, 32, 48, 64};
     int num_digits = sizeof(digits_list) / sizeof(digits_list[0]);
@@ -99,10 +92,10 @@ int main() {
     Mew e = mul(&a, &b);
     Mew f = divm(&a, &b);
     
-    Mew w1 = add_mod(&a, &b, &l);
-    Mew w2 = sub_mod(&a, &b, &l);
-    Mew w3 = mul_mod(&a, &b, &l);
-    //Mew w4 = add_mod(&a, &b, &l);
+    Mew w1 = mod_add(&a, &b, &l);
+    Mew w2 = mod_subtract(&a, &b, &l);
+    Mew w3 = mod_multiply(&a, &b, &l);
+    //Mew w4 = mod_add(&a, &b, &l);
     
     
     print_hex(&c);
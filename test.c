@@ -139,17 +139,17 @@ int main(void) {
     expect("16 mod 13 = 3", mod_str, "3");
     free(mod_str);
     
-    Mew add_mod_result = add_mod(&a8, &b8, &mod_base);
+    Mew add_mod_result = mod_add(&a8, &b8, &mod_base);
     char *add_mod_str = to_hex(&add_mod_result);
     expect("(16 + 7) mod 13 = 10", add_mod_str, "a");
     free(add_mod_str);
     
-    Mew sub_mod_result = sub_mod(&a8, &b8, &mod_base);
+    Mew sub_mod_result = mod_subtract(&a8, &b8, &mod_base);
     char *sub_mod_str = to_hex(&sub_mod_result);
     expect("(16 - 7) mod 13 = 9", sub_mod_str, "9");
     free(sub_mod_str);
     
-    Mew mul_mod_result = mul_mod(&a8, &b8, &mod_base);
+    Mew mul_mod_result = mod_multiply(&a8, &b8, &mod_base);
     char *mul_mod_str = to_hex(&mul_mod_result);
     expect("(16 * 7) mod 13 = 8", mul_mod_str, "8");
     free(mul_mod_str);
@@ -158,7 +158,7 @@ int main(void) {
     Mew exp9 = from_hex("4");
     Mew mod9 = from_hex("b");
     
-    Mew pow_mod_result = pow_mod(&base9, &exp9, &mod9);
+    Mew pow_mod_result = mod_pow_barrett(&base9, &exp9, &mod9);
     char *pow_mod_str = to_hex(&pow_mod_result);
     expect("3^4 mod 11 = 4", pow_mod_str, "4");
     free(pow_mod_str);
@@ -166,7 +166,7 @@ int main(void) {
     Mew a10 = from_hex("5");
     Mew mod10 = from_hex("13");
     
-    Mew sqr_mod_result = sqr_mod(&a10, &mod10);
+    Mew sqr_mod_result = mod_square(&a10, &mod10);
     char *sqr_mod_str = to_hex(&sqr_mod_result);
     expect("5^2 mod 19 = 6", sqr_mod_str, "6");
     free(sqr_mod_str);
@@ -192,8 +192,8 @@ int main(void) {
     Mew large_a = from_hex("123456789");
     Mew large_b = from_hex("abcdef12");
     
-    Mew large_add_mod = add_mod(&large_a, &large_b, &large_mod);
-    Mew large_mul_mod = mul_mod(&large_a, &large_b, &large_mod);
+    Mew large_add_mod = mod_add(&large_a, &large_b, &large_mod);
+    Mew large_mul_mod = mod_multiply(&large_a, &large_b, &large_mod);
     
     if (cmp(&large_add_mod, &large_mod) < 0 && cmp(&large_mul_mod, &large_mod) < 0) {
         printf("ok\n");
@@ -213,14 +213,14 @@ int main(void) {
     
     Mew a_mod = modm(&a13, &mod13);
     Mew b_mod = modm(&b13, &mod13);
-    Mew right13 = add_mod(&a_mod, &b_mod, &mod13);
+    Mew right13 = mod_add(&a_mod, &b_mod, &mod13);
     
     expect_mew("(a+b) mod m = [(a mod m)+(b mod m)] mod m", &left13, &right13);
     
     Mew ab_mul13 = mul(&a13, &b13);
     Mew left_mul13 = modm(&ab_mul13, &mod13);
     
-    Mew right_mul13 = mul_mod(&a_mod, &b_mod, &mod13);
+    Mew right_mul13 = mod_multiply(&a_mod, &b_mod, &mod13);
     
     expect_mew("(a*b) mod m = [(a mod m)*(b mod m)] mod m", &left_mul13, &right_mul13);
     
@@ -230,7 +230,7 @@ int main(void) {
     Mew small = from_hex("2");
     Mew large = from_hex("8");
     
-    Mew sub_neg_result = sub_mod(&small, &large, &mod14);
+    Mew sub_neg_result = mod_subtract(&small, &large, &mod14);
     char *sub_neg_str = to_hex(&sub_neg_result);
     expect("(2 - 8) mod 10 = 4", sub_neg_str, "4");
     free(sub_neg_str);
@@ -241,7 +241,7 @@ int main(void) {
     Mew exp15 = from_hex("a");
     Mew mod15 = from_hex("1f");
     
-    Mew pow_large_result = pow_mod(&base15, &exp15, &mod15);
+    Mew pow_large_result = mod_pow_barrett(&base15, &exp15, &mod15);
     char *pow_large_str = to_hex(&pow_large_result);
     expect("2^10 mod 31 = 1", pow_large_str, "1");
     free(pow_large_str);
@@ -254,16 +254,16 @@ int main(void) {
     Mew zero_mod = modm(&zero_val, &mod16);
     expect_mew("0 mod m = 0", &zero_val, &zero_mod);
     
-    Mew add_zero = add_mod(&a8, &zero_val, &mod16);
+    Mew add_zero = mod_add(&a8, &zero_val, &mod16);
     expect_mew("a + 0 mod m = a mod m", &add_zero, &mod_result);
     
     printf("\n=== barett ===\n");
     
     Mew large_num = from_hex("123456789abcdef");
     Mew barrett_mod = from_hex("100000000");
-    Mew mu = compute_barrett_mu(&barrett_mod);
+    Mew mu = barrett_mu(&barrett_mod);
     
-    Mew barrett_result = barrett_reduce(&large_num, &barrett_mod, &mu);
+    Mew barrett_result = barrett_reduction(&large_num, &barrett_mod, &mu);
     Mew normal_mod = modm(&large_num, &barrett_mod);
     
     expect_mew("barrett reduction == normal mod", &barrett_result, &normal_mod);
@@ -274,13 +274,715 @@ int main(void) {
     Mew exp18 = from_hex("3");
     Mew mod18 = from_hex("d");
     
-    Mew direct_pow = pow_mod(&base18, &exp18, &mod18);
+    Mew direct_pow = mod_pow_barrett(&base18, &exp18, &mod18);
     
     Mew base_mod = modm(&base18, &mod18);
-    Mew indirect_pow = pow_mod(&base_mod, &exp18, &mod18);
+    Mew indirect_pow = mod_pow_barrett(&base_mod, &exp18, &mod18);
     
     expect_mew("a^b mod m = (a mod m)^b mod m", &direct_pow, &indirect_pow);
     
+    printf("\n=== multi-exponentiation ===\n");
+
+    Mew me_mod = from_hex("f123456789abcdef0123456789abcdef1");
+    Mew me_bases[3] = {
+        from_hex("123456789abcdef"),
+        from_hex("fedcba9876543210fedcba"),
+        from_hex("1f")
+    };
+    Mew me_exps[3] = {
+        from_hex("10001"),
+        from_hex("deadbeefcafebabe1234"),
+        from_hex("0")
+    };
+
+    Mew me_x = mod_pow_barrett(&me_bases[0], &me_exps[0], &me_mod);
+    Mew me_y = mod_pow_barrett(&me_bases[1], &me_exps[1], &me_mod);
+    Mew me_want = mod_multiply(&me_x, &me_y, &me_mod);
+    Mew me_got = mod_multi_pow(me_bases, me_exps, 3, &me_mod);
+    expect_mew("a^x * b^y * c^0 mod n", &me_got, &me_want);
+
+    Mew me_single = mod_multi_pow(me_bases + 1, me_exps + 1, 1, &me_mod);
+    expect_mew("single base == mod_pow_barrett", &me_single, &me_y);
+
+    printf("\n=== roots ===\n");
+
+    Mew rt_a = from_hex("fffffffffffffffffffffffffffffffe00000000000000000000000000000001");
+    Mew rt_sqrt = isqrt(&rt_a);
+    char *rt_str = to_hex(&rt_sqrt);
+    expect("isqrt((2^128-1)^2)", rt_str, "ffffffffffffffffffffffffffffffff");
+    free(rt_str);
+
+    Mew rt_b = from_hex("3e8");
+    Mew rt_sqrt_b = isqrt(&rt_b);
+    rt_str = to_hex(&rt_sqrt_b);
+    expect("isqrt(1000) = 31", rt_str, "1f");
+    free(rt_str);
+
+    Mew rt_c = from_hex("3b9aca00");
+    Mew rt_cbrt = iroot(&rt_c, 3);
+    rt_str = to_hex(&rt_cbrt);
+    expect("iroot(10^9, 3) = 1000", rt_str, "3e8");
+    free(rt_str);
+
+    if (!is_square(&rt_a) || is_square(&rt_b)) {
+        printf("ne ok is_square\n");
+        exit(1);
+    }
+
+    Mew rt_root;
+    uint32_t rt_k = 0;
+    if (!is_perfect_power(&rt_c, &rt_root, &rt_k) || rt_k != 3) {
+        printf("ne ok is_perfect_power\n");
+        exit(1);
+    }
+    expect_mew("10^9 = 1000^3", &rt_root, &rt_cbrt);
+
+    printf("\n=== long division ===\n");
+
+    Mew dv_a = from_hex("1");
+    Mew dv_b = from_hex("1");
+    Mew dv_step = from_hex("9e3779b97f4a7c15f39cc0605cedc834");
+    for (int i = 0; i < 30; i++) {
+        dv_a = mul(&dv_a, &dv_step);
+        if (i < 14) dv_b = mul(&dv_b, &dv_step);
+    }
+    dv_b = add(&dv_b, &dv_step);
+
+    Mew dv_r;
+    Mew dv_q = divmod(&dv_a, &dv_b, &dv_r);
+    Mew dv_back = mul(&dv_q, &dv_b);
+    dv_back = add(&dv_back, &dv_r);
+    expect_mew("q * d + r == a (3840 / 1792 bits)", &dv_back, &dv_a);
+    if (cmp(&dv_r, &dv_b) >= 0) {
+        printf("ne ok remainder not reduced\n");
+        exit(1);
+    }
+
+    Mew dv_mu = reciprocal(&dv_b);
+    Mew dv_beta = from_u32(1);
+    dv_beta = shift_digits_high(&dv_beta, 2 * digit_len(&dv_b));
+    Mew dv_lo = mul(&dv_mu, &dv_b);
+    Mew dv_hi = add(&dv_lo, &dv_b);
+    if (cmp(&dv_lo, &dv_beta) > 0 || cmp(&dv_hi, &dv_beta) <= 0) {
+        printf("ne ok reciprocal\n");
+        exit(1);
+    }
+    printf("ok   reciprocal == floor(B^2k / d)\n");
+
+    /* both sides of the Newton threshold, including d = B^(k-1) and B^k - 1 */
+    Mew one_val = from_u32(1);
+    random_seed(28, 0);
+    for (int k = 40; k < NUM_LEN / 2; k += 3) {
+        for (int shape = 0; shape < 3; shape++) {
+            Mew d = random_bits(32 * k);
+            if (shape == 1) d = shift_digits_high(&one_val, k - 1);
+            if (shape == 2) {
+                d = shift_digits_high(&one_val, k);
+                d = sub(&d, &one_val);
+            }
+            if (digit_len(&d) != k) continue;
+
+            Mew beta = shift_digits_high(&one_val, 2 * k);
+            Mew want = divm(&beta, &d);
+            Mew got = reciprocal(&d);
+            if (cmp(&got, &want) != 0) {
+                printf("ne ok reciprocal k=%d shape=%d\n", k, shape);
+                exit(1);
+            }
+        }
+    }
+    printf("ok   reciprocal across the Newton threshold\n");
+
+    printf("\n=== special-form moduli ===\n");
+
+    Mew sf_p25519 = from_hex("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed");
+    Mew sf_p256 = from_hex("ffffffff00000001000000000000000000000000ffffffffffffffffffffffff");
+    MewMod sf_m25519 = mod_context(&sf_p25519);
+    MewMod sf_m256 = mod_context(&sf_p256);
+    if (sf_m25519.form != MOD_PSEUDO_MERSENNE || sf_m256.form != MOD_SOLINAS) {
+        printf("ne ok special form detection\n");
+        exit(1);
+    }
+
+    Mew sf_19 = from_u32(19);
+    MewMod sf_explicit = mod_context_special(255, &sf_19);
+    expect_mew("2^255 - 19 from mod_context_special", &sf_explicit.n, &sf_p25519);
+
+    Mew sf_a = from_hex("123456789abcdef0fedcba9876543210123456789abcdef0fedcba987654321");
+    Mew sf_b = from_hex("fedcba9876543210123456789abcdef0fedcba9876543210123456789abcdef");
+    Mew sf_prod = mul(&sf_a, &sf_b);
+
+    Mew sf_got = mod_multiply_ctx(&sf_m25519, &sf_a, &sf_b);
+    Mew sf_want = modm(&sf_prod, &sf_p25519);
+    expect_mew("a*b mod 2^255-19", &sf_got, &sf_want);
+
+    sf_got = mod_multiply_ctx(&sf_m256, &sf_a, &sf_b);
+    sf_want = modm(&sf_prod, &sf_p256);
+    expect_mew("a*b mod p256", &sf_got, &sf_want);
+
+    Mew sf_e = from_hex("10001");
+    Mew sf_pow = mod_pow_ctx(&sf_m256, &sf_a, &sf_e);
+    Mew sf_pow_ref = from_u32(1);
+    for (int i = 16; i >= 0; i--) {
+        Mew sq = mul(&sf_pow_ref, &sf_pow_ref);
+        sf_pow_ref = modm(&sq, &sf_p256);
+        if (bit_at(&sf_e, i)) {
+            Mew pr = mul(&sf_pow_ref, &sf_a);
+            sf_pow_ref = modm(&pr, &sf_p256);
+        }
+    }
+    expect_mew("a^65537 mod p256", &sf_pow, &sf_pow_ref);
+
+    printf("\n=== lazy reduction ===\n");
+
+    Mew lz_n = from_hex("c3a1d2e5f60718293a4b5c6d7e8f90a1b2c3d4e5f60718293a4b5c6d7e8f90a1");
+    MewMod lz_m = mod_context(&lz_n);
+    Mew lz_a = from_hex("b2c3d4e5f60718293a4b5c6d7e8f90a1c3a1d2e5f60718293a4b5c6d7e8f90a1");
+    Mew lz_b = from_hex("a1b2c3d4e5f60718293a4b5c6d7e8f90a1c3a1d2e5f60718293a4b5c6d7e8f9");
+
+    Mew lz_sum = mod_add_ctx(&lz_m, &lz_a, &lz_b);
+    Mew lz_ref = mod_add(&lz_a, &lz_b, &lz_n);
+    expect_mew("mod_add_ctx == mod_add", &lz_sum, &lz_ref);
+
+    Mew lz_diff = mod_subtract_ctx(&lz_m, &lz_b, &lz_a);
+    lz_ref = mod_subtract(&lz_b, &lz_a, &lz_n);
+    expect_mew("mod_subtract_ctx == mod_subtract", &lz_diff, &lz_ref);
+
+    /* (a + b + a - b + a) * b without reducing the additive chain */
+    Mew lz_acc = mod_add_lazy(&lz_m, &lz_a, &lz_b);
+    lz_acc = mod_add_lazy(&lz_m, &lz_acc, &lz_a);
+    lz_acc = mod_subtract_lazy(&lz_m, &lz_acc, &lz_b);
+    lz_acc = mod_add_lazy(&lz_m, &lz_acc, &lz_a);
+    if (cmp(&lz_acc, &lz_m.n4) >= 0) {
+        printf("ne ok lazy value left [0, 4n)\n");
+        exit(1);
+    }
+    Mew lz_got = mod_multiply_ctx(&lz_m, &lz_acc, &lz_b);
+
+    Mew lz_three = from_u32(3);
+    Mew lz_a3 = mul(&lz_a, &lz_three);
+    Mew lz_want = mod_multiply(&lz_a3, &lz_b, &lz_n);
+    expect_mew("lazy chain then multiply", &lz_got, &lz_want);
+
+    Mew lz_norm = mod_normalize_lazy(&lz_m, &lz_acc);
+    Mew lz_norm_ref = modm(&lz_a3, &lz_n);
+    expect_mew("mod_normalize_lazy", &lz_norm, &lz_norm_ref);
+
+    Mew lz_bad = lz_a;
+    lz_bad.chozabretto = true;
+    MewMod lz_none = mod_context(&lz_bad);
+    Mew lz_e1 = mod_add_lazy(&lz_m, &lz_bad, &lz_b);
+    Mew lz_e2 = mod_subtract_lazy(&lz_m, &lz_a, &lz_bad);
+    Mew lz_e3 = mod_normalize_lazy(&lz_none, &lz_a);
+    Mew lz_e4 = mod_add_lazy(NULL, &lz_a, &lz_b);
+    if (!lz_e1.chozabretto || !lz_e2.chozabretto || !lz_e3.chozabretto || !lz_e4.chozabretto) {
+        printf("ne ok lazy ops pass errors through\n");
+        exit(1);
+    }
+    printf("ok   lazy ops pass errors through\n");
+
+    printf("\n=== random ===\n");
+
+    MewRng rng_a, rng_b;
+    rng_seed(&rng_a, 42, 0);
+    rng_seed(&rng_b, 42, 0);
+    Mew rnd_a = random_bits_r(&rng_a, 1000);
+    Mew rnd_b = random_bits_r(&rng_b, 1000);
+    expect_mew("same seed, same stream", &rnd_a, &rnd_b);
+    if (bit_len(&rnd_a) > 1000) {
+        printf("ne ok random_bits width\n");
+        exit(1);
+    }
+
+    rng_seed(&rng_b, 42, 1);
+    rnd_b = random_bits_r(&rng_b, 1000);
+    if (cmp(&rnd_a, &rnd_b) == 0) {
+        printf("ne ok streams overlap\n");
+        exit(1);
+    }
+
+    Mew rnd_bound = from_hex("100000000000000000000000000000001");
+    random_seed(7, 0);
+    for (int i = 0; i < 1000; i++) {
+        Mew v = random_below(&rnd_bound);
+        if (cmp(&v, &rnd_bound) >= 0) {
+            printf("ne ok random_below out of range\n");
+            exit(1);
+        }
+    }
+    printf("ok   random_below stays below bound\n");
+
+    printf("\n=== hex without allocation ===\n");
+
+    const char *hx_line = "modmul 1f 2e 3d";
+    Mew hx_a = from_hex_n(hx_line + 7, 2);
+    char hx_buf[16];
+    int hx_len = to_hex_buf(&hx_a, hx_buf, sizeof(hx_buf));
+    expect("from_hex_n token", hx_buf, "1f");
+    if (hx_len != 2 || to_hex_buf(&rt_a, hx_buf, sizeof(hx_buf)) != -1) {
+        printf("ne ok to_hex_buf length\n");
+        exit(1);
+    }
+
+    printf("\n=== compiled expressions ===\n");
+
+    MewProgram *vm = vm_compile("((a * b + c) % n) ^ e % n");
+    if (!vm) {
+        printf("ne ok vm_compile\n");
+        exit(1);
+    }
+
+    Mew vm_n = from_hex("f123456789abcdef0123456789abcdef1");
+    Mew vm_e = from_hex("10001");
+    vm_set(vm, "n", &vm_n);
+    vm_set(vm, "e", &vm_e);
+    for (int i = 1; i <= 3; i++) {
+        Mew va = from_hex("123456789abcdef0123456789abcdef0123456789");
+        Mew vb = from_u32(0x9e3779b9u * i);
+        Mew vc = from_hex("fedcba9876543210fedcba9876543210fedcba9876");
+        vm_set(vm, "a", &va);
+        vm_set(vm, "b", &vb);
+        vm_set(vm, "c", &vc);
+
+        Mew t1 = mul(&va, &vb);
+        t1 = add(&t1, &vc);
+        t1 = modm(&t1, &vm_n);
+        Mew vm_want = mod_pow_barrett(&t1, &vm_e, &vm_n);
+        Mew vm_got = vm_run(vm);
+        expect_mew("((a*b + c) mod n)^e mod n", &vm_got, &vm_want);
+    }
+    vm_free(vm);
+
+    vm = vm_compile("(x - 0ff) * 10 / y");
+    Mew vx = from_hex("1000");
+    Mew vy = from_hex("3");
+    vm_set(vm, "x", &vx);
+    vm_set(vm, "y", &vy);
+    Mew vm_plain = vm_run(vm);
+    char *vm_str = to_hex(&vm_plain);
+    expect("(0x1000 - 0xff) * 0x10 / 3", vm_str, "5005");
+    free(vm_str);
+    vm_free(vm);
+
+    /* 3^(2^16) needs about 103800 bits: too wide for a Mew, so an error */
+    vm = vm_compile("x ^ y");
+    Mew vm_base = from_u32(3);
+    Mew vm_big = from_hex("10000");
+    vm_set(vm, "x", &vm_base);
+    vm_set(vm, "y", &vm_big);
+    Mew vm_over = vm_run(vm);
+    if (!vm_over.chozabretto) {
+        printf("ne ok x ^ y overflow not reported\n");
+        exit(1);
+    }
+    Mew vm_small = from_hex("28");
+    vm_set(vm, "y", &vm_small);
+    vm_over = vm_run(vm);
+    vm_str = to_hex(&vm_over);
+    expect("3 ^ 0x28", vm_str, "a8b8b452291fe821");
+    free(vm_str);
+    vm_free(vm);
+
+    if (vm_compile("a + ") || vm_compile("(a")) {
+        printf("ne ok malformed expression accepted\n");
+        exit(1);
+    }
+
+    printf("\n=== primality ===\n");
+
+    static const struct { const char *hex; bool prime; } psw_cases[] = {
+        {"7fffffffffffffffffffffffffffffff", true},   /* 2^127 - 1 */
+        {"1ffffffffffffffffffffff", true},            /* 2^89 - 1 */
+        {"ffffffff00000001000000000000000000000000ffffffffffffffffffffffff", true},
+        {"231", false},                               /* 561, Carmichael */
+        {"351591274f9af9fb", false},                  /* 149491 * 747451 * 34233211, spsp(2..23): only the Lucas test rejects it */
+        {"9d75", false},                              /* 40309 = 173 * 233, strong Lucas pseudoprime */
+        {"fffffffffffffff7fffffffffffffffe000000000000001", false}, /* (2^61-1)(2^127-1) */
+    };
+    for (size_t i = 0; i < sizeof(psw_cases) / sizeof(psw_cases[0]); i++) {
+        Mew pn = from_hex(psw_cases[i].hex);
+        if (baillie_psw(&pn) != psw_cases[i].prime) {
+            printf("ne ok baillie_psw %s\n", psw_cases[i].hex);
+            exit(1);
+        }
+        printf("ok   baillie_psw %s = %d\n", psw_cases[i].hex, psw_cases[i].prime);
+    }
+
+    Mew slpsp = from_hex("9d75");
+    Mew spsp2 = from_hex("351591274f9af9fb");
+    Mew psw_two = from_u32(2), psw_one = from_u32(1);
+    Mew spsp2_m1 = sub(&spsp2, &psw_one);
+    Mew spsp2_f = mod_pow_barrett(&psw_two, &spsp2_m1, &spsp2);
+    if (cmp(&spsp2_f, &psw_one) != 0 || !lucas_strong(&slpsp) || lucas_strong(&spsp2)) {
+        printf("ne ok lucas_strong 40309 / 3825123056546413051\n");
+        exit(1);
+    }
+
+    Mew ja = from_u32(1001), jn = from_u32(9907);
+    Mew jb = from_u32(19),   jm = from_u32(45);
+    Mew jc = from_u32(8),    jp = from_u32(21);
+    if (jacobi(&ja, &jn) != -1 || jacobi(&jb, &jm) != 1 || jacobi(&jc, &jp) != -1) {
+        printf("ne ok jacobi\n");
+        exit(1);
+    }
+    printf("ok   jacobi\n");
+
+    printf("\n=== inversion ===\n");
+
+    Mew inv_p = from_hex("ffffffff00000001000000000000000000000000ffffffffffffffffffffffff");
+    Mew inv_a = from_hex("123456789abcdef");
+    Mew inv_r = mod_inverse(&inv_a, &inv_p);
+    Mew inv_chk = mod_multiply(&inv_a, &inv_r, &inv_p);
+    Mew inv_one = from_u32(1);
+    expect_mew("a * a^-1 mod p256", &inv_chk, &inv_one);
+
+    Mew inv_even = from_u32(6), inv_m12 = from_u32(12);
+    if (!mod_inverse(&inv_even, &inv_m12).chozabretto) {
+        printf("ne ok mod_inverse 6 mod 12\n");
+        exit(1);
+    }
+
+    MewMod inv_ctx = mod_context(&inv_p);
+    Mew inv_in[5], inv_out[5], inv_scratch[5];
+    for (int i = 0; i < 5; i++) inv_in[i] = from_u32(0x10001u * (i + 3));
+    if (mod_batch_inverse(&inv_ctx, inv_in, inv_out, inv_scratch, 5) != -1) {
+        printf("ne ok mod_batch_inverse\n");
+        exit(1);
+    }
+    for (int i = 0; i < 5; i++) {
+        Mew want = mod_inverse(&inv_in[i], &inv_p);
+        expect_mew("batch inverse", &inv_out[i], &want);
+    }
+
+    Mew inv_n = from_u32(35);
+    MewMod inv_ctx35 = mod_context(&inv_n);
+    Mew inv_bad[3] = { from_u32(4), from_u32(8), from_u32(14) };
+    if (mod_batch_inverse(&inv_ctx35, inv_bad, inv_out, inv_scratch, 3) != 2) {
+        printf("ne ok mod_batch_inverse failing index\n");
+        exit(1);
+    }
+    printf("ok   mod_batch_inverse reports index 2\n");
+    if (mod_batch_inverse(&inv_ctx35, inv_bad, inv_out, inv_scratch, 0) != -2 ||
+        mod_batch_inverse(NULL, inv_bad, inv_out, inv_scratch, 3) != -2) {
+        printf("ne ok mod_batch_inverse bad arguments\n");
+        exit(1);
+    }
+    printf("ok   mod_batch_inverse bad arguments = -2\n");
+
+    printf("\n=== factoring ===\n");
+
+    Mew fr_n = from_hex("fffffffdfffffff80000001");       /* (2^31-1)(2^61-1) */
+    Mew fr_g = factor_rho(&fr_n, 1u << 20, 2, 1);
+    Mew fr_m31 = from_hex("7fffffff");
+    Mew fr_m61 = from_hex("1fffffffffffffff");
+    if (fr_g.chozabretto || (cmp(&fr_g, &fr_m31) && cmp(&fr_g, &fr_m61))) {
+        printf("ne ok factor_rho\n");
+        exit(1);
+    }
+    printf("ok   factor_rho (2^31-1)(2^61-1)\n");
+
+    Mew fe_n = from_hex("1fffffff5ffffffffffffff00000005"); /* (2^32-5)(2^89-1) */
+    Mew fe_g = factor_ecm(&fe_n, 500, 50000, 40, 2, 1);
+    Mew fe_p = from_hex("fffffffb");
+    expect_mew("factor_ecm (2^32-5)(2^89-1)", &fe_g, &fe_p);
+
+    Mew ff_pow = from_hex("a8b8b452291fe821");               /* 3^40 */
+    Mew ff_g = factor_find(&ff_pow, 2, 1);
+    Mew ff_rem = modm(&ff_pow, &ff_g);
+    if (ff_g.chozabretto || !is_zero(&ff_rem)) {
+        printf("ne ok factor_find 3^40\n");
+        exit(1);
+    }
+    printf("ok   factor_find 3^40\n");
+
+    Mew ff_prime = from_hex("7fffffffffffffffffffffffffffffff");
+    if (!factor_find(&ff_prime, 2, 1).chozabretto) {
+        printf("ne ok factor_find prime\n");
+        exit(1);
+    }
+    printf("ok   factor_find rejects 2^127-1\n");
+
+    printf("\n=== elliptic curves ===\n");
+
+    MewCurve k1 = ec_curve_secp256k1();
+    MewPoint k1_g = ec_generator(&k1);
+    Mew ec_two = from_u32(2);
+    MewPoint k1_2g = ec_mul(&k1, &ec_two, &k1_g);
+    MewPoint k1_dbl = ec_double(&k1, &k1_g);
+    Mew ec_x, ec_y;
+    ec_to_affine(&k1, &k1_2g, &ec_x, &ec_y);
+    Mew k1_2gx = from_hex("c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5");
+    expect_mew("secp256k1 2G.x", &ec_x, &k1_2gx);
+    if (!ec_equal(&k1, &k1_2g, &k1_dbl)) {
+        printf("ne ok ec_double != ec_mul 2\n");
+        exit(1);
+    }
+
+    MewCurve p256 = ec_curve_p256();
+    MewPoint p256_g = ec_generator(&p256);
+    MewPoint p256_ng = ec_mul(&p256, &p256.order, &p256_g);
+    if (!ec_on_curve(&p256, &p256_g) || !ec_is_infinity(&p256_ng)) {
+        printf("ne ok P-256 generator order\n");
+        exit(1);
+    }
+    printf("ok   P-256 n G = O\n");
+
+    MewPoint ec_sum = ec_add(&p256, &p256_g, &p256_ng);
+    if (!ec_equal(&p256, &ec_sum, &p256_g)) {
+        printf("ne ok G + O\n");
+        exit(1);
+    }
+    MewPoint ec_neg = ec_negate(&p256, &p256_g);
+    ec_sum = ec_add(&p256, &p256_g, &ec_neg);
+    if (!ec_is_infinity(&ec_sum)) {
+        printf("ne ok G + (-G)\n");
+        exit(1);
+    }
+    printf("ok   complete addition\n");
+
+    MewEcTable *ec_tab = ec_table_build(&p256, &p256_g, 256);
+    Mew ec_k = from_hex("c0ffee1234567890abcdef0123456789fedcba9876543210deadbeefcafebab");
+    MewPoint ec_var = ec_mul(&p256, &ec_k, &p256_g);
+    MewPoint ec_fix = ec_mul_table(ec_tab, &ec_k);
+    if (!ec_equal(&p256, &ec_var, &ec_fix) || !ec_on_curve(&p256, &ec_var)) {
+        printf("ne ok ec_mul_table\n");
+        exit(1);
+    }
+    printf("ok   ec_mul_table == ec_mul\n");
+    ec_table_free(ec_tab);
+
+    printf("\n=== parallel multiplication ===\n");
+
+    Mew pm_a = random_bits(120 * 32);
+    Mew pm_b = random_bits(120 * 32);
+    Mew pm_serial = mul(&pm_a, &pm_b);
+    Mew pm_sq_serial = sqr(&pm_a);
+    pool_init(4);
+    Mew pm_par = mul(&pm_a, &pm_b);
+    Mew pm_sq_par = sqr(&pm_a);
+    pool_shutdown();
+    expect_mew("pooled mul == serial mul", &pm_par, &pm_serial);
+    expect_mew("pooled sqr == serial sqr", &pm_sq_par, &pm_sq_serial);
+
+    printf("\n=== packed tables ===\n");
+
+    MewPack *pk = pack_new();
+    Mew pk_vals[4] = {
+        from_hex("0"),
+        from_hex("ffffffff00000001000000000000000000000000ffffffffffffffffffffffff"),
+        from_hex("123456789abcdef"),
+        from_hex("1fffffffffffffffffffffff"),
+    };
+    pk_vals[2].negative = true;
+    for (int i = 0; i < 4; i++) pack_append(pk, &pk_vals[i]);
+    static const uint8_t pk_bytes[] = {0x00, 0x01, 0x02, 0x03, 0xff, 0xee, 0xdd, 0xcc};
+    if (pack_load_bytes(pk, pk_bytes, sizeof(pk_bytes), 4) != 2 || pack_count(pk) != 6) {
+        printf("ne ok pack_load_bytes\n");
+        exit(1);
+    }
+    for (int i = 0; i < 4; i++) {
+        Mew back = pack_load(pk, (size_t)i);
+        if (back.negative != pk_vals[i].negative) {
+            printf("ne ok pack sign %d\n", i);
+            exit(1);
+        }
+        expect_mew("pack round trip", &back, &pk_vals[i]);
+    }
+    Mew pk_be = pack_load(pk, 5);
+    Mew pk_be_want = from_hex("ffeeddcc");
+    expect_mew("pack big-endian bytes", &pk_be, &pk_be_want);
+
+    MewView pv1 = pack_get(pk, 1), pv3 = pack_get(pk, 3);
+    Mew pk_prod = mul_view(&pv1, &pv3);
+    Mew pk_prod_want = mul(&pk_vals[1], &pk_vals[3]);
+    expect_mew("mul_view", &pk_prod, &pk_prod_want);
+
+    const char *pk_path = "test_pack.bin";
+    if (!pack_save(pk, pk_path)) {
+        printf("ne ok pack_save\n");
+        exit(1);
+    }
+    MewPack *pk_map = pack_map(pk_path);
+    if (!pk_map || pack_count(pk_map) != 6) {
+        printf("ne ok pack_map\n");
+        exit(1);
+    }
+    MewView pm1 = pack_get(pk_map, 1);
+    if (cmp_view(&pm1, &pv1) != 0 || pack_append(pk_map, &pk_vals[1])) {
+        printf("ne ok mapped pack\n");
+        exit(1);
+    }
+    printf("ok   pack_map\n");
+    pack_free(pk_map);
+    pack_free(pk);
+    remove(pk_path);
+
+    printf("\n=== square roots ===\n");
+
+    static const char *sq_primes[] = {
+        "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff",  /* 3 mod 4 */
+        "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed",  /* 5 mod 8 */
+        "ffffffff00000001",                                                  /* 2^32 | p - 1 */
+    };
+    for (int i = 0; i < 3; i++) {
+        Mew sq_p = from_hex(sq_primes[i]);
+        Mew sq_x = from_hex("123456789abcdef0fedcba9876543210");
+        Mew sq_a = mod_square(&sq_x, &sq_p);
+        Mew sq_r = mod_sqrt(&sq_a, &sq_p);
+        Mew sq_back = mod_square(&sq_r, &sq_p);
+        expect_mew("mod_sqrt(x^2)^2", &sq_back, &sq_a);
+
+        /* a non-residue times a square is a non-residue */
+        Mew sq_n = from_u32(2);
+        while (jacobi(&sq_n, &sq_p) != -1) sq_n.numberArray[0]++;
+        Mew sq_nr = mod_multiply(&sq_n, &sq_a, &sq_p);
+        if (!mod_sqrt(&sq_nr, &sq_p).chozabretto) {
+            printf("ne ok mod_sqrt accepted a non-residue\n");
+            exit(1);
+        }
+    }
+
+    MewPoint sq_g = ec_generator(&p256);
+    MewPoint sq_dec;
+    if (!ec_decompress(&p256, &p256.gx, p256.gy.numberArray[0] & 1, &sq_dec) ||
+        !ec_equal(&p256, &sq_dec, &sq_g)) {
+        printf("ne ok ec_decompress\n");
+        exit(1);
+    }
+    printf("ok   ec_decompress P-256 G\n");
+
+    printf("\n=== hashing and discrete logs ===\n");
+
+    Mew hs_a = from_hex("123456789abcdef0123456789abcdef");
+    Mew hs_b = copy(&hs_a);
+    hs_b.numberArray[NUM_LEN - 1] = 0;
+    MewView hs_v = view_of(&hs_a);
+    if (hash_mew(&hs_a, 1) != hash_mew(&hs_b, 1) || hash_mew(&hs_a, 1) != hash_view(&hs_v, 1) ||
+        hash_mew(&hs_a, 1) == hash_mew(&hs_a, 2)) {
+        printf("ne ok hash_mew\n");
+        exit(1);
+    }
+
+    MewTable *tb = table_new(0, 42);
+    Mew tb_key = from_hex("fedcba9876543210fedcba9876543210");
+    for (uint32_t i = 0; i < 1000; i++) {
+        Mew k = mul_one(&tb_key, i + 1);
+        table_put(tb, &k, i);
+    }
+    table_put(tb, &tb_key, 7777);
+    uint64_t tb_v = 0;
+    Mew tb_k500 = mul_one(&tb_key, 501);
+    Mew tb_miss = from_u32(3);
+    if (table_count(tb) != 1000 || !table_get(tb, &tb_k500, &tb_v) || tb_v != 500 ||
+        !table_get(tb, &tb_key, &tb_v) || tb_v != 7777 || table_get(tb, &tb_miss, NULL)) {
+        printf("ne ok MewTable\n");
+        exit(1);
+    }
+    printf("ok   MewTable put/get/overwrite\n");
+    table_free(tb);
+
+    MewTable *tf = table_new_fingerprint(1000, 42);
+    for (uint32_t i = 0; i < 1000; i++) {
+        Mew k = mul_one(&tb_key, i + 1);
+        table_put(tf, &k, i);
+    }
+    if (table_count(tf) != 1000 || !table_get(tf, &tb_k500, &tb_v) || tb_v != 500 ||
+        table_get(tf, &tb_miss, NULL) || table_bytes(tf) >= 1000 * sizeof(Mew)) {
+        printf("ne ok MewTable fingerprint\n");
+        exit(1);
+    }
+    printf("ok   MewTable fingerprint, %zu bytes\n", table_bytes(tf));
+    table_free(tf);
+
+    Mew dl_p = from_hex("1fffffffffffffff");                     /* 2^61 - 1 */
+    MewMod dl_m = mod_context(&dl_p);
+    Mew dl_g = from_u32(37);
+    Mew dl_e = from_u32(0xa5c3f1);
+    Mew dl_h = mod_pow_ctx(&dl_m, &dl_g, &dl_e);
+    uint64_t dl_x = 0;
+    if (!dlog_bsgs(&dl_m, &dl_g, &dl_h, 1u << 24, 1u << 20, 2, &dl_x) || dl_x != 0xa5c3f1) {
+        printf("ne ok dlog_bsgs\n");
+        exit(1);
+    }
+    printf("ok   dlog_bsgs = %llx\n", (unsigned long long)dl_x);
+    dl_x = 0;
+    if (!dlog_bsgs(&dl_m, &dl_g, &dl_h, 1u << 24, 1u << 12, 1, &dl_x) || dl_x != 0xa5c3f1) {
+        printf("ne ok dlog_bsgs small table\n");
+        exit(1);
+    }
+    printf("ok   dlog_bsgs in 4 KiB\n");
+    dl_x = 0;
+    if (!dlog_kangaroo(&dl_m, &dl_g, &dl_h, 1u << 24, 1, &dl_x) || dl_x != 0xa5c3f1) {
+        printf("ne ok dlog_kangaroo\n");
+        exit(1);
+    }
+    printf("ok   dlog_kangaroo = %llx\n", (unsigned long long)dl_x);
+
+    printf("\n=== exponent shapes ===\n");
+
+    Mew ex_n = from_hex("d8a7f6e5c4b3a291807f6e5d4c3b2a1908f7e6d5c4b3a29180f7e6d5c4b3a293");
+    MewMod ex_m = mod_context(&ex_n);
+    Mew ex_b = from_hex("3141592653589793238462643383279502884197169399375105820974944592");
+    Mew ex_acc = from_u32(1);
+    for (uint32_t e = 0; e <= 300; e++) {
+        Mew ee = from_u32(e);
+        Mew r = mod_pow_ctx(&ex_m, &ex_b, &ee);
+        if (cmp(&r, &ex_acc) != 0) {
+            printf("ne ok mod_pow_ctx chain e=%u\n", e);
+            exit(1);
+        }
+        ex_acc = mod_multiply_ctx(&ex_m, &ex_acc, &ex_b);
+    }
+    printf("ok   mod_pow_ctx e = 0..300 against repeated multiply\n");
+
+    Mew ex_f4 = from_u32(65537), ex_f4m = from_u32(65536);
+    Mew ex_r1 = mod_pow_ctx(&ex_m, &ex_b, &ex_f4);
+    Mew ex_r2 = mod_pow_ctx(&ex_m, &ex_b, &ex_f4m);
+    ex_r2 = mod_multiply_ctx(&ex_m, &ex_r2, &ex_b);
+    expect_mew("b^65537 = b^65536 b", &ex_r1, &ex_r2);
+
+    Mew ex_e1 = from_hex("f00dfacec0ffee1234567890abcdef0123456789abcdef");
+    Mew ex_e2 = from_hex("1badb002deadbeef");
+    Mew ex_e12 = add(&ex_e1, &ex_e2);
+    Mew ex_p1 = mod_pow_ctx(&ex_m, &ex_b, &ex_e1);
+    Mew ex_p2 = mod_pow_ctx(&ex_m, &ex_b, &ex_e2);
+    Mew ex_lhs = mod_pow_ctx(&ex_m, &ex_b, &ex_e12);
+    Mew ex_rhs = mod_multiply_ctx(&ex_m, &ex_p1, &ex_p2);
+    expect_mew("b^(e1+e2) = b^e1 b^e2", &ex_lhs, &ex_rhs);
+    Mew ex_again = mod_pow_ctx(&ex_m, &ex_b, &ex_e1);
+    expect_mew("cached recoding", &ex_again, &ex_p1);
+
+    printf("\n=== residue number system ===\n");
+
+    MewRns *rns = rns_new(&ex_n);
+    if (!rns || rns_channels(rns) < 9) {
+        printf("ne ok rns_new\n");
+        exit(1);
+    }
+    Mew rns_big = mul(&ex_b, &ex_b);
+    Mew rns_want = mod_reduce(&ex_m, &rns_big);
+    MewRnsValue rns_v = rns_from_mew(rns, &rns_big);
+    Mew rns_back = rns_to_mew(rns, &rns_v);
+    expect_mew("rns round trip", &rns_back, &rns_want);
+
+    MewRnsValue rns_x = rns_from_mew(rns, &ex_b);
+    MewRnsValue rns_y = rns_from_mew(rns, &ex_p2);
+    MewRnsValue rns_xy = rns_mul(rns, &rns_x, &rns_y);
+    Mew rns_prod = rns_to_mew(rns, &rns_xy);
+    Mew rns_expect = mod_multiply_ctx(&ex_m, &ex_b, &ex_p2);
+    expect_mew("rns_mul", &rns_prod, &rns_expect);
+
+    Mew rns_pw = rns_pow(rns, &ex_b, &ex_e1);
+    expect_mew("rns_pow", &rns_pw, &ex_p1);
+    rns_free(rns);
+
+    Mew rns_even = from_u32(1000);
+    if (rns_new(&rns_even) != NULL) {
+        printf("ne ok rns_new even modulus\n");
+        exit(1);
+    }
+    printf("ok   rns_new rejects an even modulus\n");
+
     printf("\n ok\n");
 
     return 0;